@@ -1,749 +1,1794 @@
-/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
-*
-* This file is part of libcitygml library
-* http://code.google.com/p/libcitygml
-*
-* libcitygml is free software: you can redistribute it and/or modify
-* it under the terms of the GNU Lesser General Public License as published by
-* the Free Software Foundation, either version 2.1 of the License, or
-* (at your option) any later version.
-*
-* libcitygml is distributed in the hope that it will be useful,
-* but WITHOUT ANY WARRANTY; without even the implied warranty of
-* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-* GNU Lesser General Public License for more details.
-*/
-
-#ifndef __CITYGML_H__
-#define __CITYGML_H__
-
-#include <iostream>
-#include <string>
-#include <vector>
-#include <sstream>
-#include <map>
-#include <stdio.h>
-#include <stdlib.h>
-#include "vecs.h"
-
-#define LIBCITYGML_VERSION_MAJOR 0
-#define LIBCITYGML_VERSION_MINOR 1
-#define LIBCITYGML_VERSION_REVISION 4
-
-#define LIBCITYGML_VERSIONSTR "0.1.4"
-
-#if defined( _MSC_VER ) && defined( LIBCITYGML_DYNAMIC )
-#	ifdef LIBCITYGML_BUILD
-#		define LIBCITYGML_EXPORT __declspec( dllexport )
-#	else
-#		define LIBCITYGML_EXPORT __declspec( dllimport )
-#	endif
-#else
-#	define LIBCITYGML_EXPORT
-#endif
-
-class Tesselator;
-
-namespace citygml 
-{
-	class CityModel;
-
-	enum CityObjectsType {
-		COT_GenericCityObject           = 1 << 0,
-		COT_Building                    = 1 << 1,
-		COT_Room                        = 1 << 2,
-		COT_BuildingInstallation        = 1 << 3,
-		COT_BuildingFurniture           = 1 << 4,
-		COT_Door                        = 1 << 5,
-		COT_Window                      = 1 << 6,
-		COT_CityFurniture               = 1 << 7,
-		COT_Track                       = 1 << 8,
-		COT_Road                        = 1 << 9,
-		COT_Railway                     = 1 << 10,
-		COT_Square                      = 1 << 11,
-		COT_PlantCover                  = 1 << 12,
-		COT_SolitaryVegetationObject    = 1 << 13,
-		COT_WaterBody                   = 1 << 14,
-		COT_TINRelief                   = 1 << 15,
-		COT_LandUse                     = 1 << 16,
-		COT_Tunnel						= 1 << 17,
-		COT_Bridge						= 1 << 18,
-		COT_BridgeConstructionElement	= 1 << 19,
-		COT_BridgeInstallation			= 1 << 20, 
-		COT_BridgePart                  = 1 << 21,
-		COT_BuildingPart                = 1 << 22,
-
-		COT_WallSurface                 = 1 << 23,
-		COT_RoofSurface                 = 1 << 24,
-		COT_GroundSurface               = 1 << 25,
-		COT_ClosureSurface              = 1 << 26,
-		COT_FloorSurface                = 1 << 27,
-		COT_InteriorWallSurface         = 1 << 28,
-		COT_CeilingSurface              = 1 << 29,
-
-		COT_All                         = 0xFFFFFFFF
-	};
-
-	typedef unsigned int CityObjectsTypeMask;
-
-	///////////////////////////////////////////////////////////////////////////////
-	// Parsing routines
-
-	// Parameters:
-	// objectsMask: a string describing the objects types that must or must not be parsed
-	//    examples: "All&~LandUse&~TINRelief" to parse everything but landuses and TIN reliefs
-	//              "Road&Railway" to parse only roads & railways
-	// minLOD: the minimal LOD that will be parsed
-	// maxLOD: the maximal LOD that will be parsed
-	// optimize: merge geometries & polygons that share the same appearance in the same object in order to reduce the global hierarchy
-	// pruneEmptyObjects: remove the objects which do not contains any geometrical entity
-	// tesselate: convert the interior & exteriors polygons to triangles
-	// destSRS: the SRS (WKT, EPSG, OGC URN, etc.) where the coordinates must be transformed, default ("") is no transformation
-
-	class ParserParams
-	{
-	public:
-		ParserParams( void ) : objectsMask( "All" ), minLOD( 0 ), maxLOD( 4 ), optimize( false ), pruneEmptyObjects( false ), tesselate( true ), destSRS( "" ) { }
-
-	public:
-		std::string objectsMask; 
-		unsigned int minLOD; 
-		unsigned int maxLOD;
-		bool optimize; 
-		bool pruneEmptyObjects; 
-		bool tesselate;
-		std::string destSRS;
-	};
-
-	LIBCITYGML_EXPORT CityModel* load( std::istream& stream, const ParserParams& params );
-
-	LIBCITYGML_EXPORT CityModel* load( const std::string& fileName, const ParserParams& params );
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class Envelope
-	{
-		friend class CityGMLHandler;
-	public:
-		Envelope( void ) {}
-
-		Envelope( const TVec3d& lowerBound, const TVec3d& upperBound )
-		{ 
-			_lowerBound = lowerBound; 
-			_upperBound = upperBound; 
-		}
-
-		inline const TVec3d& getLowerBound( void ) const { return _lowerBound; }
-		inline const TVec3d& getUpperBound( void ) const { return _upperBound; }
-
-	protected:
-		TVec3d _lowerBound;
-		TVec3d _upperBound;
-	};
-
-	typedef std::map< std::string, std::string > AttributesMap;
-	///////////////////////////////////////////////////////////////////////////////
-	// Base object associated with an unique id and a set of attributes (key-value pairs)
-	class Object 
-	{
-		friend class CityGMLHandler;
-		friend std::ostream& operator<<( std::ostream&, const Object & );
-	public:
-		Object( const std::string& id ) : _id( id ) { if ( _id == "" ) { std::stringstream ss; ss << "PtrId_" << this; _id = ss.str(); } }
-
-		virtual ~Object( void ) {}
-
-		inline const std::string& getId( void ) const { return _id; }
-
-		inline std::string getAttribute( const std::string& name ) const
-		{
-			std::map< std::string, std::string >::const_iterator elt = _attributes.find( name );
-			return elt != _attributes.end() ? elt->second : "";
-		}
-
-		inline const AttributesMap& getAttributes() const { return _attributes; }
-
-		inline AttributesMap& getAttributes() { return _attributes; }
-
-	protected:
-		inline void setAttribute( const std::string& name, const std::string& value, bool forceOnExist = true )
-		{
-			if ( !forceOnExist )
-			{
-				std::map< std::string, std::string >::const_iterator elt = _attributes.find( name );
-				if ( elt != _attributes.end() ) return;
-			}
-			_attributes[ name ] = value;				
-		}
-
-	protected:
-		std::string _id;
-
-		AttributesMap _attributes;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class Appearance : public Object
-	{
-		friend class CityGMLHandler;
-	public:
-		Appearance( const std::string& id, const std::string& typeString ) : Object( id ), _typeString( typeString ), _isFront(true) {}
-
-		virtual ~Appearance( void ) {}
-
-		inline std::string getType( void ) const { return _typeString; }
-		inline bool getIsFront( void ) const { return _isFront; }
-
-		virtual std::string toString( void ) const { return _typeString + " " + _id; }
-
-	protected:
-		std::string _typeString;
-		bool _isFront;
-	};
-
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class Texture : virtual public Appearance
-	{
-		friend class CityGMLHandler;
-		
-	public:
-		typedef enum WrapMode 
-		{
-			WM_NONE = 0,	// the resulting color is fully transparent
-			WM_WRAP,		// the texture is repeated
-			WM_MIRROR,		// the texture is repeated and mirrored
-			WM_CLAMP,		// the texture is clamped to its edges
-			WM_BORDER		// the resulting color is specified by the borderColor element (RGBA)
-		} WrapMode;
-
-		Texture( const std::string& id ) : Appearance( id, "Texture" ), _repeat( false ), _wrapMode( WM_NONE ) {}
-
-		inline std::string getUrl( void ) const { return _url; }
-
-		inline bool getRepeat( void ) const { return _repeat; }
-
-		inline WrapMode getWrapMode( void ) const { return _wrapMode; }
-
-		inline TVec4f getBorderColor( void ) const { return _borderColor; }
-
-		inline std::string toString( void ) const { return Appearance::toString() + " (url: " + _url + ")"; }
-
-	protected:
-		std::string _url;
-		bool _repeat;
-		WrapMode _wrapMode;
-		TVec4f _borderColor;
-	};
-
-	class GeoreferencedTexture : public Texture
-	{
-		friend class CityGMLHandler;
-
-	public:
-		GeoreferencedTexture( const std::string& id ) : Appearance( id, "GeoreferencedTexture" ), Texture( id ), _preferWorldFile(true) {}
-
-		inline bool getPreferWorldFile( void ) const { return _preferWorldFile; }
-
-		// TODO support referencePoint and orientation
-
-	protected:
-		bool _preferWorldFile;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class Material : virtual public Appearance
-	{
-		friend class CityGMLHandler;
-	public:
-		Material( const std::string& id ) : Appearance( id, "Material" ), _ambientIntensity( 0.f ), _shininess( 0.f ), _transparency( 0.f ) {}
-
-		inline TVec3f getDiffuse( void ) const { return _diffuse; }
-		inline TVec3f getEmissive( void ) const { return _emissive; }
-		inline TVec3f getSpecular( void ) const { return _specular; }
-		inline float getAmbientIntensity( void ) const { return _ambientIntensity; }
-		inline float getShininess( void ) const { return _shininess; }
-		inline float getTransparency( void ) const { return _transparency; }
-
-	protected:
-		TVec3f _diffuse;
-		TVec3f _emissive;
-		TVec3f _specular;
-		float _ambientIntensity;
-		float _shininess;
-		float _transparency;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	typedef std::vector<TVec2f> TexCoords;
-
-	class AppearanceManager 
-	{
-		friend class CityGMLHandler;
-		friend class CityModel;
-	public:
-		AppearanceManager( void );
-
-		~AppearanceManager( void );
-
-		typedef enum ForSide 
-		{
-			FS_ANY = 0,	// appearance for any side
-			FS_FRONT,	// appearance for front side
-			FS_BACK		// appearance for back side
-		};
-
-		inline Appearance* getAppearance( const std::string& nodeid ) const
-		// Deprecated, use getMaterial and getTexture instead.
-		{
-			return getAppearance< Appearance* >( nodeid );
-		}
-		inline Material* getMaterial( const std::string& nodeid ) const
-		{
-			return getAppearance< Material* >( nodeid );
-		}
-
-		inline Texture* getTexture( const std::string& nodeid ) const
-		{
-			return getAppearance< Texture* >( nodeid );
-		}
-
-		// Getter for the front&back material if there is any.
-		inline Material* getMaterialFront( const std::string& nodeid ) const
-		{
-			return getAppearance< Material* >( nodeid, FS_FRONT );
-		}
-		inline Material* getMaterialBack( const std::string& nodeid ) const
-		{
-			return getAppearance< Material* >( nodeid, FS_BACK );
-		}
-
-		inline bool getTexCoords( const std::string& nodeid, TexCoords &texCoords) const
-		{
-			texCoords.clear();
-			std::map<std::string, TexCoords*>::const_iterator it = _texCoordsMap.find( nodeid );
-			if ( it == _texCoordsMap.end() || !it->second ) return false;
-			texCoords = *it->second;
-			return true;
-		}
-
-		inline Tesselator* getTesselator( void ) { return _tesselator; }
-
-	protected:
-		void refresh( void );
-
-		template < typename AppType > AppType getAppearance( const std::string& nodeid, ForSide side = FS_ANY ) const;
-		void addAppearance( Appearance* );
-		void assignNode( const std::string& nodeid );
-		bool assignTexCoords( TexCoords* );
-
-		void finish( void );
-
-	protected:
-		std::string _lastId;
-		TexCoords* _lastCoords;
-
-		std::vector< Appearance* > _appearances;
-
-		std::map< std::string, std::vector< Appearance* > > _appearancesMap;
-
-		std::map<std::string, TexCoords*> _texCoordsMap;
-        std::vector<TexCoords*> _obsoleteTexCoords;
-
-		Tesselator* _tesselator;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class LinearRing : public Object
-	{
-		friend class CityGMLHandler;
-		friend class Polygon;
-	public:
-		LinearRing( const std::string& id, bool isExterior ) : Object( id ), _exterior( isExterior ) {}
-
-		bool isExterior( void ) const { return _exterior; }
-
-		inline unsigned int size( void ) const { return _vertices.size(); }
-
-		inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
-
-		inline void addVertex( const TVec3d& v ) { _vertices.push_back( v ); }
-
-		LIBCITYGML_EXPORT TVec3d computeNormal( void ) const;
-
-	protected:
-		inline std::vector<TVec3d>& getVertices( void ) { return _vertices; }
-
-		void finish( TexCoords* );
-
-	protected:		
-		bool _exterior;
-
-		std::vector<TVec3d> _vertices;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	class Geometry;
-
-	class Polygon : public Object
-	{
-		friend class CityGMLHandler;
-		friend class Geometry;
-		friend class Tesseletor;
-		friend class CityModel;
-	public:
-		enum AppearanceSide {
-			FRONT = 0,
-			BACK,
-			_NUMBER_OF_SIDES
-		};
-
-		Polygon( const std::string& id ) : 
-		  Object( id ), _appearance( 0 ), _texture( 0 ), _exteriorRing( 0 ), _negNormal( false ), _geometry( 0 ) 
-		  {
-			  _materials[ FRONT ] = 0;
-			  _materials[ BACK ] = 0;
-		  }
-
-		LIBCITYGML_EXPORT ~Polygon( void );
-
-		// Get the vertices
-		inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
-
-		// Get the indices
-		inline const std::vector<unsigned int>& getIndices( void ) const { return _indices; }
-
-		// Get the normals
-		inline const std::vector<TVec3f>& getNormals( void ) const { return _normals; }
-
-		// Get texture coordinates
-		inline const TexCoords& getTexCoords( void ) const { return _texCoords; }
-
-		// Get the appearance
-		inline const Appearance* getAppearance( void ) const { return _appearance; } // Deprecated! Use getMaterial and getTexture instead
-		inline const Material* getMaterial( void ) const 
-		{ 
-			if ( _materials[ FRONT ] ) { return _materials[ FRONT ]; }
-			else { return _materials[ BACK ]; }
-		}
-		inline const Texture* getTexture( void ) const { return _texture; }
-		inline const Material* getMaterialFront( void ) const { return _materials[ FRONT ]; }
-		inline const Material* getMaterialBack( void ) const { return _materials[ BACK ]; }
-
-	protected:
-		void finish( AppearanceManager&, bool doTesselate );
-		void finish( AppearanceManager&, Appearance*,  bool doTesselate );
-
-		void addRing( LinearRing* );
-
-		void tesselate( AppearanceManager &, const TVec3d& );
-		void mergeRings( AppearanceManager & );
-		void clearRings( void );
-
-		TVec3d computeNormal( void );
-
-		bool merge( Polygon* );
-
-	protected:
-		std::vector<TVec3d> _vertices;
-		std::vector<TVec3f> _normals;
-		std::vector<unsigned int> _indices;
-
-		Appearance* _appearance;
-		Material* _materials[ _NUMBER_OF_SIDES ];
-		Texture* _texture;
-
-		TexCoords _texCoords; 
-
-		LinearRing* _exteriorRing;
-		std::vector<LinearRing*> _interiorRings;
-
-		bool _negNormal;
-
-		Geometry *_geometry;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	enum GeometryType 
-	{
-		GT_Unknown = 0,
-		GT_Roof,
-		GT_Wall,
-		GT_Ground,
-		GT_Closure,
-		GT_Floor,
-		GT_InteriorWall,
-		GT_Ceiling,
-	};
-
-	class Geometry : public Object
-	{
-		friend class CityGMLHandler;
-		friend class CityObject;
-		friend std::ostream& operator<<( std::ostream&, const citygml::Geometry& );
-	public:
-		Geometry( const std::string& id, GeometryType type = GT_Unknown, unsigned int lod = 0 ) : Object( id ), _type( type ), _lod( lod ) {}
-
-		LIBCITYGML_EXPORT ~Geometry();
-
-		// Get the geometry LOD
-		inline unsigned int getLOD( void ) const { return _lod; }
-
-		// Get the polygons
-		inline unsigned int size( void ) const { return _polygons.size(); }
-		inline Polygon* operator[]( unsigned int i ) { return _polygons[i]; }
-		inline const Polygon* operator[]( unsigned int i ) const { return _polygons[i]; }
-
-		inline GeometryType getType( void ) const { return _type; }
-
-	protected:
-		void addPolygon( Polygon* );
-
-		void finish( AppearanceManager&, Appearance*, const ParserParams& );
-
-		bool merge( Geometry* );
-
-	protected:
-		GeometryType _type;
-
-		unsigned int _lod;
-
-		std::vector< Polygon* > _polygons;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	LIBCITYGML_EXPORT std::string getCityObjectsClassName( CityObjectsTypeMask mask );
-
-	LIBCITYGML_EXPORT CityObjectsTypeMask getCityObjectsTypeMaskFromString( const std::string& stringMask );
-
-	class CityObject : public Object 
-	{
-		friend class CityGMLHandler;
-		friend class CityModel;
-		friend std::ostream& operator<<( std::ostream&, const CityObject & );
-	public:
-		CityObject( const std::string& id, CityObjectsType type ) : Object( id ), _type( type ) {}
-
-		virtual ~CityObject()
-		{ 
-			std::vector< Geometry* >::const_iterator it = _geometries.begin();
-			for ( ; it != _geometries.end(); ++it ) delete *it;
-		}
-
-		// Get the object type
-		inline CityObjectsType getType( void ) const { return _type; }
-
-		inline std::string getTypeAsString( void ) const { return getCityObjectsClassName( _type ); }
-
-		// Return the envelope (ie. the bounding box) of the object
-		inline const Envelope& getEnvelope( void ) const { return _envelope; }
-
-		// Get the default diffuse color of this object class
-		virtual TVec4f getDefaultColor( void ) const = 0;
-
-		// Get the number of geometries contains in the object
-		inline unsigned int size( void ) const { return _geometries.size(); }
-
-		// Access the geometries
-		inline const Geometry* getGeometry( unsigned int i ) const { return _geometries[i]; }
-
-		// Access the children
-		inline unsigned int getChildCount( void ) const { return _children.size(); }
-
-		inline const CityObject* getChild( unsigned int i ) const { return ( i < getChildCount() ) ? _children[i] : 0; }
-
-		inline CityObject* getChild( unsigned int i ) { return ( i < getChildCount() ) ? _children[i] : 0; }
-
-		inline const std::vector< CityObject* >& getChildren( void ) const { return _children; }
-
-		inline std::vector< CityObject* >& getChildren( void ) { return _children; }
-
-	protected:
-		void finish( AppearanceManager&, const ParserParams& );
-
-	protected:
-		CityObjectsType _type;
-
-		Envelope _envelope;
-
-		std::vector< Geometry* > _geometries;		
-		std::vector< CityObject* > _children;
-	};
-
-#define MAKE_RGBA( _r_, _g_, _b_, _a_ ) TVec4f( _r_/255.f, _g_/255.f, _b_/255.f, _a_/255.f )
-#define MAKE_RGB( _r_, _g_, _b_ ) MAKE_RGBA( _r_, _g_, _b_, 255 )
-
-	// Helper macro to declare a new CityObject type from its name & default color
-#define DECLARE_SIMPLE_OBJECT_CLASS( _name_, _defcolor_ ) \
-	class _name_ : public CityObject \
-	{\
-	public:\
-	_name_( const std::string& id ) : CityObject( id, COT_ ## _name_ ) {}\
-	inline TVec4f getDefaultColor( void ) const { return _defcolor_; }\
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Building, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BuildingPart, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Room, MAKE_RGB( 181, 180, 163 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Door, MAKE_RGB( 145, 53, 13 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Window, MAKE_RGBA( 147, 170, 209, 60 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BuildingInstallation, MAKE_RGB( 186, 186, 177 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BuildingFurniture, MAKE_RGB( 227, 225, 157 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( CityFurniture, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( WaterBody, MAKE_RGB( 48, 133, 187 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( PlantCover, MAKE_RGB( 0, 184, 0 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( SolitaryVegetationObject, MAKE_RGB( 10, 184, 10 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Track, MAKE_RGB( 171, 131, 46 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Road, MAKE_RGB( 159, 159, 159 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Railway, MAKE_RGB( 180, 180, 180 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Square, MAKE_RGB( 159, 159, 159 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( TINRelief, MAKE_RGB( 100, 230, 10 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Tunnel, MAKE_RGB( 180, 180, 150 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( Bridge, MAKE_RGB( 245, 30, 30 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BridgeConstructionElement, MAKE_RGB( 245, 20, 20 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BridgeInstallation, MAKE_RGB( 245, 80, 80 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( BridgePart, MAKE_RGB( 245, 50, 50 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( GenericCityObject, MAKE_RGB( 100, 130, 0 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( WallSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( RoofSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( GroundSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( ClosureSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( FloorSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( InteriorWallSurface, MAKE_RGB( 186, 184, 135 ) );
-
-	DECLARE_SIMPLE_OBJECT_CLASS( CeilingSurface, MAKE_RGB( 186, 184, 135 ) );
-
-
-	class LandUse : public CityObject 
-	{
-	public:
-		LandUse( const std::string& id ) : CityObject( id, COT_LandUse ) {}
-
-		inline TVec4f getDefaultColor( void ) const
-		{ 
-			std::string c = getAttribute( "class" );
-			if ( c != "" )
-			{
-				int cl = atoi( c.c_str() );
-				switch ( cl ) 
-				{
-				case 1000: return MAKE_RGB( 150, 143, 134 );	// Settlement Area
-				case 1100: return MAKE_RGB( 133, 83, 101 );		// Undeveloped Area
-				case 2000: return MAKE_RGB( 159, 159, 159 );	// Traffic
-				case 3000: return MAKE_RGB( 79, 212, 53 );		// Vegetation
-				case 4000: return MAKE_RGB( 67, 109, 247 );		// Water
-				}
-			}
-			return MAKE_RGB( 10, 230, 1 ); 
-		}
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	typedef std::vector< CityObject* > CityObjects;
-	typedef std::map< CityObjectsType, CityObjects > CityObjectsMap;
-
-	class CityModel : public Object
-	{
-		friend class CityGMLHandler;
-	public:
-		CityModel( const std::string& id = "CityModel" ) : Object( id ) {} 
-
-		LIBCITYGML_EXPORT ~CityModel( void );
-
-		// Return the envelope (ie. the bounding box) of the model
-		inline const Envelope& getEnvelope( void ) const { return _envelope; }
-
-		// Return the translation parameters of the model
-		inline const TVec3d& getTranslationParameters( void ) const { return _translation; }
-
-		// Get the number of city objects 
-		inline unsigned int size( void ) const
-		{ 
-			unsigned int count = 0;
-			CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
-			for ( ; it != _cityObjectsMap.end(); ++it ) count += it->second.size();
-			return count; 
-		}
-
-		inline const CityObjectsMap& getCityObjectsMap( void ) const { return _cityObjectsMap; }
-
-		inline const CityObjects* getCityObjectsByType( CityObjectsType type ) const
-		{ 
-			CityObjectsMap::const_iterator it = _cityObjectsMap.find( type );
-			return ( it != _cityObjectsMap.end() ) ? &it->second : 0;
-		}
-
-		// Return the roots elements of the model. You can then navigate the hierarchy using object->getChildren().
-		inline const CityObjects& getCityObjectsRoots( void ) const { return _roots; }
-
-		inline const std::string& getSRSName( void ) const { return _srsName; }
-
-	protected:
-		void addCityObject( CityObject* o );
-
-		inline void addCityObjectAsRoot( CityObject* o ) { if ( o ) _roots.push_back( o ); }
-
-		void finish( const ParserParams& );
-
-	protected:
-		Envelope _envelope;
-
-		CityObjects _roots;
-
-		CityObjectsMap _cityObjectsMap;
-
-		AppearanceManager _appearanceManager;
-		
-		std::string _srsName;
-		
-		TVec3d _translation;
-	};
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	std::ostream& operator<<( std::ostream&, const citygml::Envelope& );
-	std::ostream& operator<<( std::ostream&, const citygml::Object& );
-	std::ostream& operator<<( std::ostream&, const citygml::Geometry& );
-	std::ostream& operator<<( std::ostream&, const citygml::CityObject& );
-	std::ostream& operator<<( std::ostream&, const citygml::CityModel & );
-}
-
-#endif // __CITYGML_H__
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#ifndef __CITYGML_H__
+#define __CITYGML_H__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <cstddef>
+#include <atomic>
+#include <limits>
+#include <stdio.h>
+#include <stdlib.h>
+#include "vecs.h"
+
+#define LIBCITYGML_VERSION_MAJOR 0
+#define LIBCITYGML_VERSION_MINOR 1
+#define LIBCITYGML_VERSION_REVISION 4
+
+#define LIBCITYGML_VERSIONSTR "0.1.4"
+
+#if defined( _MSC_VER ) && defined( LIBCITYGML_DYNAMIC )
+#	ifdef LIBCITYGML_BUILD
+#		define LIBCITYGML_EXPORT __declspec( dllexport )
+#	else
+#		define LIBCITYGML_EXPORT __declspec( dllimport )
+#	endif
+#else
+#	define LIBCITYGML_EXPORT
+#endif
+
+class Tesselator;
+
+namespace citygml 
+{
+	class CityModel;
+	class MappedCityModel;
+	class SpatialIndex;
+
+	enum CityObjectsType {
+		COT_GenericCityObject           = 1 << 0,
+		COT_Building                    = 1 << 1,
+		COT_Room                        = 1 << 2,
+		COT_BuildingInstallation        = 1 << 3,
+		COT_BuildingFurniture           = 1 << 4,
+		COT_Door                        = 1 << 5,
+		COT_Window                      = 1 << 6,
+		COT_CityFurniture               = 1 << 7,
+		COT_Track                       = 1 << 8,
+		COT_Road                        = 1 << 9,
+		COT_Railway                     = 1 << 10,
+		COT_Square                      = 1 << 11,
+		COT_PlantCover                  = 1 << 12,
+		COT_SolitaryVegetationObject    = 1 << 13,
+		COT_WaterBody                   = 1 << 14,
+		COT_TINRelief                   = 1 << 15,
+		COT_LandUse                     = 1 << 16,
+		COT_Tunnel						= 1 << 17,
+		COT_Bridge						= 1 << 18,
+		COT_BridgeConstructionElement	= 1 << 19,
+		COT_BridgeInstallation			= 1 << 20, 
+		COT_BridgePart                  = 1 << 21,
+		COT_BuildingPart                = 1 << 22,
+
+		COT_WallSurface                 = 1 << 23,
+		COT_RoofSurface                 = 1 << 24,
+		COT_GroundSurface               = 1 << 25,
+		COT_ClosureSurface              = 1 << 26,
+		COT_FloorSurface                = 1 << 27,
+		COT_InteriorWallSurface         = 1 << 28,
+		COT_CeilingSurface              = 1 << 29,
+
+		COT_All                         = 0xFFFFFFFF
+	};
+
+	typedef unsigned int CityObjectsTypeMask;
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Parsing routines
+
+	// Parameters:
+	// objectsMask: a string describing the objects types that must or must not be parsed
+	//    examples: "All&~LandUse&~TINRelief" to parse everything but landuses and TIN reliefs
+	//              "Road&Railway" to parse only roads & railways
+	// minLOD: the minimal LOD that will be parsed
+	// maxLOD: the maximal LOD that will be parsed
+	// optimize: merge geometries & polygons that share the same appearance in the same object in order to reduce the global hierarchy
+	// mergeChildren: when optimizing, first move the geometries of the children objects (eg. the boundary surfaces of a building) into their topmost parent
+	// pruneEmptyObjects: remove the objects which do not contains any geometrical entity
+	// tesselate: convert the interior & exteriors polygons to triangles
+	// destSRS: the SRS (WKT, EPSG, OGC URN, etc.) where the coordinates must be transformed, default ("") is no transformation
+	// sharedBuffers: store the polygons vertices, indices & texture coordinates in model-wide buffers (see CityModel::getGeometryBuffers)
+	// threads: number of threads used to finish the model (appearances assignment, tesselation...), 0 means one per hardware thread
+	// lazyTesselation: keep the polygons rings and tesselate each polygon on the first access to its vertices, indices, normals or texture coordinates
+	//    (ignored when optimize is set, since merging needs the tesselated polygons; polygons still pending are not put in the shared buffers)
+	// vertexTolerance: distance under which consecutive vertices of a ring are considered duplicated and merged
+	// spatialIndex: build the spatial index of the city objects envelopes at the end of the parsing (see CityModel::getSpatialIndex)
+	// cacheDir: directory of the binary sidecar files caching the models parsed from files (see save_binary), loaded instead of
+	//    parsing while the file (size, modification time & sampled content) and the parameters above are unchanged.
+	//    Default is the CITYGML_CACHE_DIR environment variable. The directory is created if missing (but not its parents),
+	//    no caching when empty or when the directory can not be written
+
+	class ParserParams
+	{
+	public:
+		ParserParams( void ) : objectsMask( "All" ), minLOD( 0 ), maxLOD( 4 ), optimize( false ), mergeChildren( false ), pruneEmptyObjects( false ), tesselate( true ), destSRS( "" ), sharedBuffers( false ), lazyTesselation( false ), threads( 1 ), spatialIndex( false ), 
+			vertexTolerance( sqrt( std::numeric_limits<float>::epsilon() ) ), cacheDir( getenv( "CITYGML_CACHE_DIR" ) ? getenv( "CITYGML_CACHE_DIR" ) : "" ) { }
+
+	public:
+		std::string objectsMask; 
+		unsigned int minLOD; 
+		unsigned int maxLOD;
+		bool optimize; 
+		bool mergeChildren;
+		bool pruneEmptyObjects; 
+		bool tesselate;
+		std::string destSRS;
+		bool sharedBuffers;
+		bool lazyTesselation;
+		unsigned int threads;
+		bool spatialIndex;
+		double vertexTolerance;
+		std::string cacheDir;
+	};
+
+	// Activity of a worker thread during the model finish (see ParserParams::threads & CityModel::getFinishStats)
+	class WorkerStats
+	{
+	public:
+		WorkerStats( void ) : tasks( 0 ), stolenTasks( 0 ), cost( 0 ), busyTime( 0. ), elapsedTime( 0. ) {}
+
+		// Ratio of the elapsed time spent running tasks
+		inline double getUtilization( void ) const { return ( elapsedTime > 0. ) ? busyTime / elapsedTime : 0.; }
+
+	public:
+		unsigned int tasks;
+		unsigned int stolenTasks;	// tasks taken from another worker queue
+		size_t cost;				// estimated cost (vertices count) of the tasks run
+		double busyTime;			// seconds spent running tasks
+		double elapsedTime;			// seconds spent in the parallel phases
+	};
+
+	LIBCITYGML_EXPORT CityModel* load( std::istream& stream, const ParserParams& params );
+
+	LIBCITYGML_EXPORT CityModel* load( const std::string& fileName, const ParserParams& params );
+
+	// Binary cache of a finished model: a versioned, little-endian, block structured file holding the objects hierarchy, 
+	// attributes, appearances & tesselated geometry, which is loaded back with a few bulk reads and no text parsing.
+	// The polygons of a loaded model are stored in its shared buffers (see ParserParams::sharedBuffers).
+	// An existing file is replaced as a whole (written aside then renamed), so that the models mapping it keep
+	// reading the previous content: a mapped file must never be modified in place.
+	// Return false (resp. null) on error.
+	LIBCITYGML_EXPORT bool save_binary( const CityModel& model, const std::string& fileName );
+
+	LIBCITYGML_EXPORT CityModel* load_binary( const std::string& fileName );
+
+	// Memory map a binary model file and give read-only views over it (see MappedCityModel), null on error.
+	// Delete the model to unmap the file.
+	LIBCITYGML_EXPORT MappedCityModel* map_binary( const std::string& fileName );
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class Envelope
+	{
+		friend class CityGMLHandler;
+	public:
+		Envelope( void ) {}
+
+		Envelope( const TVec3d& lowerBound, const TVec3d& upperBound )
+		{ 
+			_lowerBound = lowerBound; 
+			_upperBound = upperBound; 
+		}
+
+		inline const TVec3d& getLowerBound( void ) const { return _lowerBound; }
+		inline const TVec3d& getUpperBound( void ) const { return _upperBound; }
+
+	protected:
+		TVec3d _lowerBound;
+		TVec3d _upperBound;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Handle on an immutable string stored once in a StringPool.
+	// Two handles from the same pool are equal if and only if they refer to the same string.
+
+	class InternedString
+	{
+		friend class StringPool;
+	public:
+		InternedString( void ) : _str( 0 ) {}
+
+		// Make a non pooled handle on a string, only to be used as a lookup key in containers ordered by content
+		static inline InternedString key( const std::string& s ) { return InternedString( &s ); }
+
+		inline bool isNull( void ) const { return _str == 0; }
+
+		inline const std::string* get( void ) const { return _str; }
+
+		inline const std::string& str( void ) const { static const std::string empty; return _str ? *_str : empty; }
+
+		inline operator const std::string&( void ) const { return str(); }
+
+		inline bool operator==( const InternedString& s ) const { return _str == s._str; }
+
+		inline bool operator!=( const InternedString& s ) const { return _str != s._str; }
+
+		// Lexicographic order, handles on the same string are not compared char by char
+		inline bool operator<( const InternedString& s ) const { return _str != s._str && str() < s.str(); }
+
+	private:
+		explicit InternedString( const std::string* s ) : _str( s ) {}
+
+	private:
+		const std::string* _str;
+	};
+
+	inline std::ostream& operator<<( std::ostream& os, const InternedString& s ) { return os << s.str(); }
+
+	// Model-wide pool of strings (attribute names, texture urls, referenced ids...) which keeps one canonical copy of each distinct string
+	class StringPool
+	{
+	public:
+		// Get the handle on the pooled copy of the string, the string is added to the pool if needed
+		inline InternedString intern( const std::string& s ) { return InternedString( &*_strings.insert( s ).first ); }
+
+		// Get the handle on the pooled copy of the string, or a null handle if the string is not pooled
+		inline InternedString find( const std::string& s ) const 
+		{ 
+			std::unordered_set< std::string >::const_iterator it = _strings.find( s );
+			return it != _strings.end() ? InternedString( &*it ) : InternedString();
+		}
+
+		inline unsigned int size( void ) const { return _strings.size(); }
+
+	private:
+		// Hashed, and its elements never move, so that the handles stay valid
+		std::unordered_set< std::string > _strings;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Value of an object attribute: the text as read in the file, and for the typed attributes 
+	// (measuredHeight, gen:doubleAttribute, gen:intAttribute...) the value parsed once at load time
+	class AttributeValue
+	{
+		friend class ModelSerializer;
+	public:
+		enum Type 
+		{
+			AT_String = 0,
+			AT_Double,
+			AT_Integer,
+			AT_Date,	// ISO 8601 date (YYYY-MM-DD)
+			AT_Uri
+		};
+
+		AttributeValue( void ) : _type( AT_String ), _integer( 0 ) {}
+
+		LIBCITYGML_EXPORT AttributeValue( const std::string& text, Type type = AT_String );
+
+		inline Type getType( void ) const { return _type; }
+
+		inline const std::string& asString( void ) const { return _text; }
+
+		// Numeric accessors, the text is parsed on the fly for non numeric attributes
+		LIBCITYGML_EXPORT double asDouble( void ) const;
+		LIBCITYGML_EXPORT long long asInteger( void ) const;
+
+		// Get the year, month & day of a date attribute
+		LIBCITYGML_EXPORT bool asDate( int& year, int& month, int& day ) const;
+
+		inline operator const std::string&( void ) const { return _text; }
+
+	private:
+		Type _type;
+		std::string _text;
+		union 
+		{
+			double _double;
+			long long _integer;	// integer value, or YYYYMMDD for dates
+		};
+	};
+
+	inline std::ostream& operator<<( std::ostream& os, const AttributeValue& v ) { return os << v.asString(); }
+
+	// Flat attributes storage: a vector of (name, value) pairs sorted by name
+	class AttributesMap
+	{
+	public:
+		typedef std::pair< InternedString, AttributeValue > value_type;
+		typedef std::vector< value_type >::const_iterator const_iterator;
+		typedef std::vector< value_type >::iterator iterator;
+
+		inline const_iterator begin( void ) const { return _attributes.begin(); }
+		inline const_iterator end( void ) const { return _attributes.end(); }
+		inline iterator begin( void ) { return _attributes.begin(); }
+		inline iterator end( void ) { return _attributes.end(); }
+
+		inline unsigned int size( void ) const { return _attributes.size(); }
+		inline bool empty( void ) const { return _attributes.empty(); }
+
+		inline const_iterator find( const std::string& name ) const 
+		{ 
+			const_iterator it = lowerBound( InternedString::key( name ) );
+			return ( it != end() && it->first.str() == name ) ? it : end();
+		}
+
+		inline iterator find( const std::string& name ) 
+		{ 
+			iterator it = lowerBound( InternedString::key( name ) );
+			return ( it != end() && it->first.str() == name ) ? it : end();
+		}
+
+		inline const AttributeValue* get( const std::string& name ) const
+		{
+			const_iterator it = find( name );
+			return it != end() ? &it->second : 0;
+		}
+
+		inline void erase( iterator it ) { _attributes.erase( it ); }
+
+		// Set the value of an attribute, an existing value is only replaced if forceOnExist is set
+		inline void set( InternedString name, const AttributeValue& value, bool forceOnExist = true )
+		{
+			iterator it = lowerBound( name );
+			if ( it != end() && !( name < it->first ) ) { if ( forceOnExist ) it->second = value; return; }
+			_attributes.insert( it, value_type( name, value ) );
+		}
+
+	private:
+		static inline bool compareNames( const value_type& a, const value_type& b ) { return a.first < b.first; }
+
+		inline const_iterator lowerBound( InternedString name ) const 
+		{ 
+			return std::lower_bound( _attributes.begin(), _attributes.end(), value_type( name, AttributeValue() ), compareNames ); 
+		}
+
+		inline iterator lowerBound( InternedString name ) 
+		{ 
+			return std::lower_bound( _attributes.begin(), _attributes.end(), value_type( name, AttributeValue() ), compareNames ); 
+		}
+
+	private:
+		std::vector< value_type > _attributes;
+	};
+	///////////////////////////////////////////////////////////////////////////////
+	// Monotonic memory arena: memory is carved out of large blocks and only released, all at once, with the arena.
+	// Each CityModel owns one in which the parser allocates the model objects.
+
+	class ObjectArena
+	{
+	public:
+		ObjectArena( size_t blockSize = 256 * 1024 ) : _blockSize( blockSize ), _current( 0 ), _remaining( 0 ), _allocated( 0 ) {}
+
+		LIBCITYGML_EXPORT ~ObjectArena( void );
+
+		LIBCITYGML_EXPORT void* allocate( size_t size );
+
+		// Copy an array of plain values to the arena, null if it is empty
+		template< class T > inline T* copy( const T* data, size_t count )
+		{
+			if ( count == 0 ) return 0;
+			T* p = (T*)allocate( count * sizeof( T ) );
+			std::uninitialized_copy( data, data + count, p );
+			return p;
+		}
+
+		// Total size of the memory blocks held by the arena
+		inline size_t getAllocatedSize( void ) const { return _allocated; }
+
+	private:
+		ObjectArena( const ObjectArena& );
+		ObjectArena& operator=( const ObjectArena& );
+
+	private:
+		size_t _blockSize;
+		char* _current;
+		size_t _remaining;
+		size_t _allocated;
+		std::vector< char* > _blocks;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Base object associated with an unique id and a set of attributes (key-value pairs)
+	class Object 
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+		friend std::ostream& operator<<( std::ostream&, const Object & );
+	public:
+		Object( const std::string& id ) : _id( id ), _hasPtrId( false ) {}
+
+		virtual ~Object( void ) {}
+
+		// Objects are allocated either on the heap or in an arena (ie. the one of the model they belong to). 
+		// Deleting an object allocated in an arena runs its destructor but does not release its memory, 
+		// it is released with the arena.
+		LIBCITYGML_EXPORT static void* operator new( size_t size );
+		LIBCITYGML_EXPORT static void* operator new( size_t size, ObjectArena* arena );
+		LIBCITYGML_EXPORT static void operator delete( void* p );
+		LIBCITYGML_EXPORT static void operator delete( void* p, ObjectArena* arena );
+
+		// Get the object id. Objects without gml:id get a synthetic one which is only generated on the first call, 
+		// under a lock so that concurrent readers may share the object.
+		inline const std::string& getId( void ) const { return _id.empty() ? getPtrId() : _id; }
+
+		// Return true if the object has a gml:id
+		inline bool hasId( void ) const { return !_id.empty(); }
+
+		// Get the text of an attribute, an empty string if the attribute is not set
+		inline const std::string& getAttribute( const std::string& name ) const
+		{
+			static const std::string empty;
+			const AttributeValue* value = _attributes.get( name );
+			return value ? value->asString() : empty;
+		}
+
+		inline const AttributeValue* getAttributeValue( const std::string& name ) const { return _attributes.get( name ); }
+
+		inline double getAttributeAsDouble( const std::string& name, double defaultValue = 0. ) const
+		{
+			const AttributeValue* value = _attributes.get( name );
+			return value ? value->asDouble() : defaultValue;
+		}
+
+		inline long long getAttributeAsInteger( const std::string& name, long long defaultValue = 0 ) const
+		{
+			const AttributeValue* value = _attributes.get( name );
+			return value ? value->asInteger() : defaultValue;
+		}
+
+		inline const AttributesMap& getAttributes() const { return _attributes; }
+
+		inline AttributesMap& getAttributes() { return _attributes; }
+
+	protected:
+		inline void setAttribute( InternedString name, const AttributeValue& value, bool forceOnExist = true )
+		{
+			_attributes.set( name, value, forceOnExist );
+		}
+
+	protected:
+		LIBCITYGML_EXPORT const std::string& getPtrId( void ) const;
+
+	protected:
+		std::string _id;
+
+		// The synthetic id of an object without gml:id, set once by getPtrId
+		mutable std::string _ptrId;
+		mutable std::atomic<bool> _hasPtrId;
+
+		AttributesMap _attributes;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class Appearance : public Object
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+	public:
+		Appearance( const std::string& id, const std::string& typeString ) : Object( id ), _typeString( typeString ), _isFront(true) {}
+
+		virtual ~Appearance( void ) {}
+
+		inline std::string getType( void ) const { return _typeString; }
+		inline bool getIsFront( void ) const { return _isFront; }
+
+		virtual std::string toString( void ) const { return _typeString + " " + getId(); }
+
+	protected:
+		std::string _typeString;
+		bool _isFront;
+	};
+
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class Texture : virtual public Appearance
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+		
+	public:
+		typedef enum WrapMode 
+		{
+			WM_NONE = 0,	// the resulting color is fully transparent
+			WM_WRAP,		// the texture is repeated
+			WM_MIRROR,		// the texture is repeated and mirrored
+			WM_CLAMP,		// the texture is clamped to its edges
+			WM_BORDER		// the resulting color is specified by the borderColor element (RGBA)
+		} WrapMode;
+
+		Texture( const std::string& id ) : Appearance( id, "Texture" ), _repeat( false ), _wrapMode( WM_NONE ) {}
+
+		inline const std::string& getUrl( void ) const { return _url; }
+
+		inline bool getRepeat( void ) const { return _repeat; }
+
+		inline WrapMode getWrapMode( void ) const { return _wrapMode; }
+
+		inline TVec4f getBorderColor( void ) const { return _borderColor; }
+
+		inline std::string toString( void ) const { return Appearance::toString() + " (url: " + _url.str() + ")"; }
+
+	protected:
+		InternedString _url;
+		bool _repeat;
+		WrapMode _wrapMode;
+		TVec4f _borderColor;
+	};
+
+	class GeoreferencedTexture : public Texture
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+
+	public:
+		GeoreferencedTexture( const std::string& id ) : Appearance( id, "GeoreferencedTexture" ), Texture( id ), _preferWorldFile(true) {}
+
+		inline bool getPreferWorldFile( void ) const { return _preferWorldFile; }
+
+		// TODO support referencePoint and orientation
+
+	protected:
+		bool _preferWorldFile;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class Material : virtual public Appearance
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+	public:
+		Material( const std::string& id ) : Appearance( id, "Material" ), _ambientIntensity( 0.f ), _shininess( 0.f ), _transparency( 0.f ) {}
+
+		inline TVec3f getDiffuse( void ) const { return _diffuse; }
+		inline TVec3f getEmissive( void ) const { return _emissive; }
+		inline TVec3f getSpecular( void ) const { return _specular; }
+		inline float getAmbientIntensity( void ) const { return _ambientIntensity; }
+		inline float getShininess( void ) const { return _shininess; }
+		inline float getTransparency( void ) const { return _transparency; }
+
+	protected:
+		TVec3f _diffuse;
+		TVec3f _emissive;
+		TVec3f _specular;
+		float _ambientIntensity;
+		float _shininess;
+		float _transparency;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	typedef std::vector<TVec2f> TexCoords;
+
+	// Read-only view on a range of elements, either owned by an object or stored in the model shared buffers.
+	// A view with a null stride repeats a single element, eg. the normal of a planar polygon for each of its vertices.
+	template< class T > class ArrayView
+	{
+	public:
+		class const_iterator
+		{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const T* pointer;
+			typedef const T& reference;
+
+			const_iterator( const ArrayView* view, unsigned int i ) : _view( view ), _i( i ) {}
+
+			inline const T& operator*( void ) const { return (*_view)[_i]; }
+			inline const T* operator->( void ) const { return &(*_view)[_i]; }
+			inline const_iterator& operator++( void ) { ++_i; return *this; }
+			inline const_iterator operator++( int ) { const_iterator it( *this ); ++_i; return it; }
+			inline bool operator==( const const_iterator& it ) const { return _i == it._i; }
+			inline bool operator!=( const const_iterator& it ) const { return _i != it._i; }
+
+		protected:
+			const ArrayView* _view;
+			unsigned int _i;
+		};
+
+		ArrayView( void ) : _data( 0 ), _size( 0 ), _stride( 1 ) {}
+		ArrayView( const T* data, unsigned int size, unsigned int stride = 1 ) : _data( data ), _size( size ), _stride( stride ) {}
+		ArrayView( const std::vector<T>& v ) : _data( v.empty() ? 0 : &v[0] ), _size( v.size() ), _stride( 1 ) {}
+
+		inline unsigned int size( void ) const { return _size; }
+		inline bool empty( void ) const { return _size == 0; }
+
+		// True if every element of the view is the same one
+		inline bool isUniform( void ) const { return _stride == 0; }
+
+		inline const T& operator[]( unsigned int i ) const { return _data[ i * _stride ]; }
+
+		// Raw access to the elements, only contiguous if the view is not uniform
+		inline const T* data( void ) const { return _data; }
+
+		inline const_iterator begin( void ) const { return const_iterator( this, 0 ); }
+		inline const_iterator end( void ) const { return const_iterator( this, _size ); }
+
+		// Copy the viewed elements
+		inline std::vector<T> toVector( void ) const { return std::vector<T>( begin(), end() ); }
+
+	protected:
+		const T* _data;
+		unsigned int _size;
+		unsigned int _stride;
+	};
+
+	// Pool of the parsed texture coordinates lists, which keeps one copy of each distinct list
+	// (atlased models often reuse the same coordinates for many rings, eg. repeated facade tiles).
+	// It lives as long as the model, whose packed polygons may point to its lists.
+	class TexCoordsPool
+	{
+	public:
+		// Get the pooled copy of the list, the list is moved into the pool if needed
+		inline const TexCoords* intern( TexCoords& texCoords ) { return &*_texCoords.insert( std::move( texCoords ) ).first; }
+
+		inline unsigned int size( void ) const { return _texCoords.size(); }
+
+		inline void clear( void ) { _texCoords.clear(); }
+
+	private:
+		struct Hash
+		{
+			inline size_t operator()( const TexCoords& texCoords ) const
+			{
+				size_t seed = texCoords.size();
+				for ( unsigned int i = 0; i < texCoords.size(); i++ )
+				{
+					seed ^= std::hash< float >()( texCoords[i].x ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+					seed ^= std::hash< float >()( texCoords[i].y ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+				}
+				return seed;
+			}
+		};
+
+		// Hashed by content, and its elements never move, so that the returned pointers stay valid
+		std::unordered_set< TexCoords, Hash > _texCoords;
+	};
+
+	class AppearanceManager 
+	{
+		friend class CityGMLHandler;
+		friend class CityModel;
+		friend class CityObject;
+		friend class Geometry;
+		friend class Polygon;
+		friend class ModelSerializer;
+	public:
+		AppearanceManager( StringPool& );
+
+		~AppearanceManager( void );
+
+		typedef enum ForSide 
+		{
+			FS_ANY = 0,	// appearance for any side
+			FS_FRONT,	// appearance for front side
+			FS_BACK		// appearance for back side
+		};
+
+		inline Appearance* getAppearance( const std::string& nodeid ) const
+		// Deprecated, use getMaterial and getTexture instead.
+		{
+			const NodeAppearances* slots = getNodeAppearances( getNode( nodeid ) );
+			return slots ? slots->appearance : 0;
+		}
+		inline Material* getMaterial( const std::string& nodeid ) const
+		{
+			const NodeAppearances* slots = getNodeAppearances( getNode( nodeid ) );
+			return slots ? slots->getMaterial( FS_ANY ) : 0;
+		}
+
+		inline Texture* getTexture( const std::string& nodeid ) const
+		{
+			const NodeAppearances* slots = getNodeAppearances( getNode( nodeid ) );
+			return slots ? slots->getTexture( FS_ANY ) : 0;
+		}
+
+		// Getter for the front&back material if there is any.
+		inline Material* getMaterialFront( const std::string& nodeid ) const
+		{
+			const NodeAppearances* slots = getNodeAppearances( getNode( nodeid ) );
+			return slots ? slots->getMaterial( FS_FRONT ) : 0;
+		}
+		inline Material* getMaterialBack( const std::string& nodeid ) const
+		{
+			const NodeAppearances* slots = getNodeAppearances( getNode( nodeid ) );
+			return slots ? slots->getMaterial( FS_BACK ) : 0;
+		}
+
+		inline bool getTexCoords( const std::string& nodeid, TexCoords &texCoords) const
+		{
+			const TexCoords* t = getTexCoords( getNode( nodeid ) );
+			if ( t ) texCoords = *t; else texCoords.clear();
+			return t != 0;
+		}
+
+		// Get the texture coordinates targeting the node without copying them, null if there are none
+		inline const TexCoords* getTexCoords( const std::string& nodeid ) const
+		{
+			return getTexCoords( getNode( nodeid ) );
+		}
+
+		inline Tesselator* getTesselator( void ) { return _tesselator; }
+
+	protected:
+		// Appearances targeting a node, sorted by type and side when they are assigned
+		// so that looking them up is a single hash probe without any dynamic_cast
+		class NodeAppearances
+		{
+		public:
+			NodeAppearances( void ) : appearance( 0 )
+			{
+				materials[0] = materials[1] = 0;
+				textures[0] = textures[1] = 0;
+			}
+
+			// FS_ANY gives the front side appearance, or else the back side one
+			inline Material* getMaterial( ForSide side ) const
+			{
+				return side == FS_ANY ? ( materials[0] ? materials[0] : materials[1] ) : materials[ side - FS_FRONT ];
+			}
+			inline Texture* getTexture( ForSide side ) const
+			{
+				return side == FS_ANY ? ( textures[0] ? textures[0] : textures[1] ) : textures[ side - FS_FRONT ];
+			}
+
+			// The first assigned appearance if it is a material (resp. a texture)
+			inline Material* getFirstMaterial( void ) const
+			{
+				for ( unsigned int i = 0; i < 2; i++ ) if ( materials[i] && materials[i] == appearance ) return materials[i];
+				return 0;
+			}
+			inline Texture* getFirstTexture( void ) const
+			{
+				for ( unsigned int i = 0; i < 2; i++ ) if ( textures[i] && textures[i] == appearance ) return textures[i];
+				return 0;
+			}
+
+		public:
+			Appearance* appearance;	// the first assigned appearance
+			Material* materials[2];	// front & back
+			Texture* textures[2];	// front & back
+		};
+
+		void refresh( void );
+
+		// Get the handle on a node id referenced by an appearance, a null handle means that no appearance targets this node
+		inline InternedString getNode( const std::string& nodeid ) const { return _stringPool.find( nodeid ); }
+
+		inline const NodeAppearances* getNodeAppearances( InternedString node ) const
+		{
+			if ( node.isNull() ) return 0;
+			std::unordered_map< const std::string*, NodeAppearances >::const_iterator it = _appearancesMap.find( node.get() );
+			return ( it != _appearancesMap.end() ) ? &it->second : 0;
+		}
+
+		inline const TexCoords* getTexCoords( InternedString node ) const
+		{
+			if ( node.isNull() ) return 0;
+			std::unordered_map< const std::string*, const TexCoords* >::const_iterator it = _texCoordsMap.find( node.get() );
+			return ( it != _texCoordsMap.end() ) ? it->second : 0;
+		}
+
+		void addAppearance( Material* );
+		void addAppearance( Texture* );
+		void assignNode( const std::string& nodeid );
+		bool assignTexCoords( TexCoords& );
+		bool assignTexCoords( const TexCoords* );
+
+		void finish( void );
+
+	protected:
+		StringPool& _stringPool;
+
+		InternedString _lastId;
+		const TexCoords* _lastCoords;
+
+		std::vector< Appearance* > _appearances;
+
+		// The last added appearance, only one of them is set
+		Material* _lastMaterial;
+		Texture* _lastTexture;
+
+		// Appearances & texture coordinates of the targeted nodes, keyed by the interned node id
+		std::unordered_map< const std::string*, NodeAppearances > _appearancesMap;
+
+		std::unordered_map< const std::string*, const TexCoords* > _texCoordsMap;
+		TexCoordsPool _texCoordsPool;
+
+		Tesselator* _tesselator;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class LinearRing : public Object
+	{
+		friend class CityGMLHandler;
+		friend class Polygon;
+	public:
+		LinearRing( const std::string& id, bool isExterior ) : Object( id ), _exterior( isExterior ) {}
+
+		bool isExterior( void ) const { return _exterior; }
+
+		inline unsigned int size( void ) const { return _vertices.size(); }
+
+		inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
+
+		inline void addVertex( const TVec3d& v ) { _vertices.push_back( v ); }
+
+		LIBCITYGML_EXPORT TVec3d computeNormal( void ) const;
+
+	protected:
+		inline std::vector<TVec3d>& getVertices( void ) { return _vertices; }
+
+		void finish( TexCoords*, unsigned int texOffset, double tolerance );
+
+	protected:		
+		bool _exterior;
+
+		std::vector<TVec3d> _vertices;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Model-wide structure of arrays holding the polygons data when ParserParams::sharedBuffers is set.
+	// Only the textured polygons have texture coordinates, one per vertex from their own offset (see Polygon::getTexCoordOffset). 
+	// Normals stay with the polygons, in the model arena.
+	class GeometryBuffers
+	{
+		friend class Polygon;
+		friend class CityModel;
+		friend class ModelSerializer;
+	public:
+		inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
+		inline const TexCoords& getTexCoords( void ) const { return _texCoords; }
+		inline const std::vector<unsigned int>& getIndices( void ) const { return _indices; }
+
+	protected:
+		template< class T > static inline T* at( std::vector<T>& v, unsigned int offset ) { return v.empty() ? 0 : &v[0] + offset; }
+
+	protected:
+		std::vector<TVec3d> _vertices;
+		TexCoords _texCoords;
+		std::vector<unsigned int> _indices;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	class Geometry;
+
+	// Part of a merged polygon coming from one of its source polygons (see ParserParams::optimize): 
+	// the source polygon id (empty if it had none) & the ranges of its vertices & indices in the merged polygon ones
+	class PolygonRange
+	{
+	public:
+		PolygonRange( const std::string& id, unsigned int vertexOffset, unsigned int vertexCount, unsigned int indexOffset, unsigned int indexCount ) 
+			: id( id ), vertexOffset( vertexOffset ), vertexCount( vertexCount ), indexOffset( indexOffset ), indexCount( indexCount ) {}
+
+	public:
+		std::string id;
+		unsigned int vertexOffset, vertexCount;
+		unsigned int indexOffset, indexCount;
+	};
+
+	class Polygon : public Object
+	{
+		friend class CityGMLHandler;
+		friend class Geometry;
+		friend class Tesseletor;
+		friend class CityModel;
+		friend class TextureAtlas;
+		friend class ModelSerializer;
+	public:
+		enum AppearanceSide {
+			FRONT = 0,
+			BACK,
+			_NUMBER_OF_SIDES
+		};
+
+		Polygon( const std::string& id ) : 
+		  Object( id ), _appearance( 0 ), _texture( 0 ), _pooledTexCoords( 0 ), _exteriorRing( 0 ), _negNormal( false ), _geometry( 0 ),
+		  _packedVertices( 0 ), _packedTexCoords( 0 ), _packedIndices( 0 ), _packedNormals( 0 ), 
+		  _vertexOffset( 0 ), _vertexCount( 0 ), _texCoordOffset( 0 ), _indexOffset( 0 ), _indexCount( 0 ),
+		  _useTesselator( false ), _pendingTesselation( false )
+		  {
+			  _materials[ FRONT ] = 0;
+			  _materials[ BACK ] = 0;
+		  }
+
+		LIBCITYGML_EXPORT ~Polygon( void );
+
+		// Get the vertices
+		inline ArrayView<TVec3d> getVertices( void ) const 
+		{ 
+			if ( isTesselationPending() ) tesselateOnDemand();
+			return _packedVertices ? ArrayView<TVec3d>( _packedVertices, _vertexCount ) : ArrayView<TVec3d>( _vertices ); 
+		}
+
+		// Get the indices (relative to the polygon vertices)
+		inline ArrayView<unsigned int> getIndices( void ) const 
+		{ 
+			if ( isTesselationPending() ) tesselateOnDemand();
+			return _packedIndices ? ArrayView<unsigned int>( _packedIndices, _indexCount ) : ArrayView<unsigned int>( _indices ); 
+		}
+
+		// Get the polygon normal (meaningless if hasUniformNormal() is false)
+		inline const TVec3f& getNormal( void ) const { return _normal; }
+
+		// True unless the polygon results from the merge of differently oriented polygons
+		inline bool hasUniformNormal( void ) const { return !_packedNormals && _normals.empty(); }
+
+		// Get the normals, one per vertex
+		inline ArrayView<TVec3f> getNormals( void ) const 
+		{ 
+			if ( isTesselationPending() ) tesselateOnDemand();
+			if ( _packedNormals ) return ArrayView<TVec3f>( _packedNormals, _vertexCount );
+			return _normals.empty() ? ArrayView<TVec3f>( &_normal, getVertices().size(), 0 ) : ArrayView<TVec3f>( _normals ); 
+		}
+
+		// Get the texture coordinates, one per vertex, or none if the polygon is not textured
+		inline ArrayView<TVec2f> getTexCoords( void ) const 
+		{ 
+			if ( isTesselationPending() ) tesselateOnDemand();
+			return _packedTexCoords ? ArrayView<TVec2f>( _packedTexCoords, _vertexCount ) : ArrayView<TVec2f>( _texCoords ); 
+		}
+
+		// True until a lazily tesselated polygon is accessed (see ParserParams::lazyTesselation)
+		inline bool isTesselationPending( void ) const { return _pendingTesselation.load( std::memory_order_acquire ); }
+
+		// Extend a bounding box with the polygon vertices, read from its rings while the tesselation is pending so that it is not forced
+		LIBCITYGML_EXPORT void extendBounds( TVec3d& lower, TVec3d& upper ) const;
+
+		// Offsets of the polygon data in the model shared buffers, when they are used
+		inline unsigned int getVertexOffset( void ) const { return _vertexOffset; }
+		inline unsigned int getTexCoordOffset( void ) const { return _texCoordOffset; }	// meaningless if the polygon has no texture coordinates
+		inline unsigned int getIndexOffset( void ) const { return _indexOffset; }
+
+		// Get the source polygons of a merged polygon, the first one being this polygon before the merge; empty if the polygon was not merged
+		inline const std::vector<PolygonRange>& getSources( void ) const { return _sources; }
+
+		// Get the appearance
+		inline const Appearance* getAppearance( void ) const { return _appearance; } // Deprecated! Use getMaterial and getTexture instead
+		inline const Material* getMaterial( void ) const 
+		{ 
+			if ( _materials[ FRONT ] ) { return _materials[ FRONT ]; }
+			else { return _materials[ BACK ]; }
+		}
+		inline const Texture* getTexture( void ) const { return _texture; }
+		inline const Material* getMaterialFront( void ) const { return _materials[ FRONT ]; }
+		inline const Material* getMaterialBack( void ) const { return _materials[ BACK ]; }
+
+	protected:
+		void finish( AppearanceManager&, Tesselator*, const ParserParams& );
+		void finish( AppearanceManager&, Tesselator*, const AppearanceManager::NodeAppearances*, const ParserParams& );
+
+		void addRing( LinearRing* );
+
+		void finishRings( AppearanceManager &, double tolerance );
+		void tesselate( Tesselator* );
+		bool tesselateConvex( void );
+		void mergeRings( void );
+		void clearRings( void );
+
+		LIBCITYGML_EXPORT void tesselateOnDemand( void ) const;
+
+		TVec3d computeNormal( void );
+
+		void merge( const std::vector< Polygon* >& );
+
+		void pack( ObjectArena&, GeometryBuffers* );
+
+		void setBuffers( GeometryBuffers&, unsigned int vertexOffset, unsigned int vertexCount, unsigned int indexOffset, unsigned int indexCount );
+
+		void setTexCoordsBuffer( GeometryBuffers&, unsigned int texCoordOffset );
+
+		// Writable texture coordinates, either the polygon own ones or its range of the model shared buffers. 
+		// The pooled ones, which other polygons may share, are first copied to the arena.
+		inline TVec2f* getTexCoordsData( ObjectArena& arena )
+		{
+			if ( isTesselationPending() ) tesselateOnDemand();
+			if ( _packedTexCoords && _pooledTexCoords ) { _packedTexCoords = arena.copy( _packedTexCoords, _vertexCount ); _pooledTexCoords = 0; }
+			if ( _packedTexCoords ) return _packedTexCoords;
+			return _texCoords.empty() ? 0 : &_texCoords[0];
+		}
+
+		// Number of vertices of the rings, ie. the tesselation cost
+		inline unsigned int getRingsVerticesCount( void ) const
+		{
+			unsigned int count = _exteriorRing ? _exteriorRing->size() : 0;
+			for ( unsigned int i = 0; i < _interiorRings.size(); i++ ) count += _interiorRings[i]->size();
+			return count;
+		}
+
+	protected:
+		std::vector<TVec3d> _vertices;
+		std::vector<unsigned int> _indices;
+
+		// The planar polygon normal, only expanded per vertex when polygons of different normals are merged
+		TVec3f _normal;
+		std::vector<TVec3f> _normals;
+
+		Appearance* _appearance;
+		Material* _materials[ _NUMBER_OF_SIDES ];
+		Texture* _texture;
+
+		TexCoords _texCoords; 
+
+		// The pooled texture coordinates the polygon ones come from; once packed, only set if the polygon points to them
+		const TexCoords* _pooledTexCoords;
+
+		std::vector<PolygonRange> _sources;
+
+		LinearRing* _exteriorRing;
+		std::vector<LinearRing*> _interiorRings;
+
+		bool _negNormal;
+
+		Geometry *_geometry;
+
+		// The polygon data once packed at the end of the model finish, either in the model shared buffers or in the model arena 
+		// (the per vertex normals always go to the arena, the texture coordinates may stay in the model pool), so that it is released 
+		// at once with the model; null while the polygon own vectors are used, eg. for the polygons still pending tesselation, 
+		// and for the texture coordinates of the untextured polygons
+		const TVec3d* _packedVertices;
+		TVec2f* _packedTexCoords;
+		const unsigned int* _packedIndices;
+		const TVec3f* _packedNormals;
+
+		// Count of the packed vertices & indices, and their offsets (and the texture coordinates one) in the model shared buffers when these are used
+		unsigned int _vertexOffset, _vertexCount;
+		unsigned int _texCoordOffset;
+		unsigned int _indexOffset, _indexCount;
+
+		// Whether the rings go through the tesselator or are just merged, and if that is still to be done
+		bool _useTesselator;
+		mutable std::atomic<bool> _pendingTesselation;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	enum GeometryType 
+	{
+		GT_Unknown = 0,
+		GT_Roof,
+		GT_Wall,
+		GT_Ground,
+		GT_Closure,
+		GT_Floor,
+		GT_InteriorWall,
+		GT_Ceiling,
+	};
+
+	class Geometry : public Object
+	{
+		friend class CityGMLHandler;
+		friend class CityObject;
+		friend class CityModel;
+		friend class ModelSerializer;
+		friend std::ostream& operator<<( std::ostream&, const citygml::Geometry& );
+	public:
+		Geometry( const std::string& id, GeometryType type = GT_Unknown, unsigned int lod = 0 ) : Object( id ), _type( type ), _lod( lod ), _inlineAppearance( false ) {}
+
+		LIBCITYGML_EXPORT ~Geometry();
+
+		// Get the geometry LOD
+		inline unsigned int getLOD( void ) const { return _lod; }
+
+		// Get the polygons
+		inline unsigned int size( void ) const { return _polygons.size(); }
+		inline Polygon* operator[]( unsigned int i ) { return _polygons[i]; }
+		inline const Polygon* operator[]( unsigned int i ) const { return _polygons[i]; }
+
+		inline GeometryType getType( void ) const { return _type; }
+
+	protected:
+		void addPolygon( Polygon* );
+
+		void finish( AppearanceManager&, Tesselator*, const AppearanceManager::NodeAppearances*, const ParserParams&, unsigned int first, unsigned int last );
+
+		void optimize( void );
+
+		void merge( const std::vector< Geometry* >& );
+
+	protected:
+		GeometryType _type;
+
+		unsigned int _lod;
+
+		// Set when an inline appearance is assigned to a geometry without gml:id, under its synthetic id
+		bool _inlineAppearance;
+
+		std::vector< Polygon* > _polygons;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	LIBCITYGML_EXPORT std::string getCityObjectsClassName( CityObjectsTypeMask mask );
+
+	LIBCITYGML_EXPORT CityObjectsTypeMask getCityObjectsTypeMaskFromString( const std::string& stringMask );
+
+	class CityObject : public Object 
+	{
+		friend class CityGMLHandler;
+		friend class CityModel;
+		friend class ModelSerializer;
+		friend std::ostream& operator<<( std::ostream&, const CityObject & );
+	public:
+		CityObject( const std::string& id, CityObjectsType type ) : Object( id ), _type( type ) {}
+
+		virtual ~CityObject()
+		{ 
+			std::vector< Geometry* >::const_iterator it = _geometries.begin();
+			for ( ; it != _geometries.end(); ++it ) delete *it;
+		}
+
+		// Get the object type
+		inline CityObjectsType getType( void ) const { return _type; }
+
+		inline std::string getTypeAsString( void ) const { return getCityObjectsClassName( _type ); }
+
+		// Return the envelope (ie. the bounding box) of the object
+		inline const Envelope& getEnvelope( void ) const { return _envelope; }
+
+		// Get the default diffuse color of this object class
+		virtual TVec4f getDefaultColor( void ) const = 0;
+
+		// Get the default diffuse color of one of the object geometries, the roofs being red whatever the object class
+		inline TVec4f getDefaultGeometryColor( const Geometry& geom ) const { return ( geom.getType() == GT_Roof ) ? TVec4f( 0.9f, 0.1f, 0.1f, 1.f ) : getDefaultColor(); }
+
+		// Get the number of geometries contains in the object
+		inline unsigned int size( void ) const { return _geometries.size(); }
+
+		// Access the geometries
+		inline const Geometry* getGeometry( unsigned int i ) const { return _geometries[i]; }
+
+		// Access the children
+		inline unsigned int getChildCount( void ) const { return _children.size(); }
+
+		inline const CityObject* getChild( unsigned int i ) const { return ( i < getChildCount() ) ? _children[i] : 0; }
+
+		inline CityObject* getChild( unsigned int i ) { return ( i < getChildCount() ) ? _children[i] : 0; }
+
+		inline const std::vector< CityObject* >& getChildren( void ) const { return _children; }
+
+		inline std::vector< CityObject* >& getChildren( void ) { return _children; }
+
+	protected:
+		void optimize( bool mergeChildren );
+
+		void moveGeometries( std::vector< Geometry* >& );
+
+		// Number of polygons of the object, and of its descendants if recursive is set
+		unsigned int getPolygonsCount( bool recursive ) const;
+
+	protected:
+		CityObjectsType _type;
+
+		Envelope _envelope;
+
+		std::vector< Geometry* > _geometries;		
+		std::vector< CityObject* > _children;
+	};
+
+#define MAKE_RGBA( _r_, _g_, _b_, _a_ ) TVec4f( _r_/255.f, _g_/255.f, _b_/255.f, _a_/255.f )
+#define MAKE_RGB( _r_, _g_, _b_ ) MAKE_RGBA( _r_, _g_, _b_, 255 )
+
+	// Helper macro to declare a new CityObject type from its name & default color
+#define DECLARE_SIMPLE_OBJECT_CLASS( _name_, _defcolor_ ) \
+	class _name_ : public CityObject \
+	{\
+	public:\
+	_name_( const std::string& id ) : CityObject( id, COT_ ## _name_ ) {}\
+	inline TVec4f getDefaultColor( void ) const { return _defcolor_; }\
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Building, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BuildingPart, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Room, MAKE_RGB( 181, 180, 163 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Door, MAKE_RGB( 145, 53, 13 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Window, MAKE_RGBA( 147, 170, 209, 60 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BuildingInstallation, MAKE_RGB( 186, 186, 177 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BuildingFurniture, MAKE_RGB( 227, 225, 157 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( CityFurniture, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( WaterBody, MAKE_RGB( 48, 133, 187 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( PlantCover, MAKE_RGB( 0, 184, 0 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( SolitaryVegetationObject, MAKE_RGB( 10, 184, 10 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Track, MAKE_RGB( 171, 131, 46 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Road, MAKE_RGB( 159, 159, 159 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Railway, MAKE_RGB( 180, 180, 180 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Square, MAKE_RGB( 159, 159, 159 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( TINRelief, MAKE_RGB( 100, 230, 10 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Tunnel, MAKE_RGB( 180, 180, 150 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( Bridge, MAKE_RGB( 245, 30, 30 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BridgeConstructionElement, MAKE_RGB( 245, 20, 20 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BridgeInstallation, MAKE_RGB( 245, 80, 80 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( BridgePart, MAKE_RGB( 245, 50, 50 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( GenericCityObject, MAKE_RGB( 100, 130, 0 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( WallSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( RoofSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( GroundSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( ClosureSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( FloorSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( InteriorWallSurface, MAKE_RGB( 186, 184, 135 ) );
+
+	DECLARE_SIMPLE_OBJECT_CLASS( CeilingSurface, MAKE_RGB( 186, 184, 135 ) );
+
+
+	class LandUse : public CityObject 
+	{
+	public:
+		LandUse( const std::string& id ) : CityObject( id, COT_LandUse ) {}
+
+		inline TVec4f getDefaultColor( void ) const
+		{ 
+			const std::string& c = getAttribute( "class" );
+			if ( c != "" )
+			{
+				int cl = atoi( c.c_str() );
+				switch ( cl ) 
+				{
+				case 1000: return MAKE_RGB( 150, 143, 134 );	// Settlement Area
+				case 1100: return MAKE_RGB( 133, 83, 101 );		// Undeveloped Area
+				case 2000: return MAKE_RGB( 159, 159, 159 );	// Traffic
+				case 3000: return MAKE_RGB( 79, 212, 53 );		// Vegetation
+				case 4000: return MAKE_RGB( 67, 109, 247 );		// Water
+				}
+			}
+			return MAKE_RGB( 10, 230, 1 ); 
+		}
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	typedef std::vector< CityObject* > CityObjects;
+	typedef std::map< CityObjectsType, CityObjects > CityObjectsMap;
+
+	class CityModel : public Object
+	{
+		friend class CityGMLHandler;
+		friend class ModelSerializer;
+		friend class ModelCache;
+		friend class TextureAtlas;
+	public:
+		CityModel( const std::string& id = "CityModel" ) : Object( id ), _appearanceManager( _stringPool ), _spatialIndex( 0 ) {} 
+
+		LIBCITYGML_EXPORT ~CityModel( void );
+
+		// Return the envelope (ie. the bounding box) of the model
+		inline const Envelope& getEnvelope( void ) const { return _envelope; }
+
+		// Return the translation parameters of the model
+		inline const TVec3d& getTranslationParameters( void ) const { return _translation; }
+
+		// Get the number of city objects 
+		inline unsigned int size( void ) const
+		{ 
+			unsigned int count = 0;
+			CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
+			for ( ; it != _cityObjectsMap.end(); ++it ) count += it->second.size();
+			return count; 
+		}
+
+		inline const CityObjectsMap& getCityObjectsMap( void ) const { return _cityObjectsMap; }
+
+		inline const CityObjects* getCityObjectsByType( CityObjectsType type ) const
+		{ 
+			CityObjectsMap::const_iterator it = _cityObjectsMap.find( type );
+			return ( it != _cityObjectsMap.end() ) ? &it->second : 0;
+		}
+
+		// Return the roots elements of the model. You can then navigate the hierarchy using object->getChildren().
+		inline const CityObjects& getCityObjectsRoots( void ) const { return _roots; }
+
+		inline const std::string& getSRSName( void ) const { return _srsName; }
+
+		// Return the buffers holding every polygon data, empty unless ParserParams::sharedBuffers was set
+		inline const GeometryBuffers& getGeometryBuffers( void ) const { return _buffers; }
+
+		// Return the activity of each worker thread during the model finish (see ParserParams::threads)
+		inline const std::vector< WorkerStats >& getFinishStats( void ) const { return _finishStats; }
+
+		// Return the spatial index of the city objects, null unless ParserParams::spatialIndex was set
+		inline const SpatialIndex* getSpatialIndex( void ) const { return _spatialIndex; }
+
+	protected:
+		void addCityObject( CityObject* o );
+
+		inline void addCityObjectAsRoot( CityObject* o ) { if ( o ) _roots.push_back( o ); }
+
+		void finish( const ParserParams& );
+
+		void packGeometry( bool shared );
+
+	protected:
+		// Declared first so that it is destroyed after every object allocated in it
+		ObjectArena _arena;
+
+		StringPool _stringPool;
+
+		Envelope _envelope;
+
+		CityObjects _roots;
+
+		CityObjectsMap _cityObjectsMap;
+
+		AppearanceManager _appearanceManager;
+
+		GeometryBuffers _buffers;
+
+		std::vector< WorkerStats > _finishStats;
+
+		SpatialIndex* _spatialIndex;
+		
+		std::string _srsName;
+		
+		TVec3d _translation;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Bulk loaded R-tree over the envelopes of the city objects of a model, which must outlive it.
+	// The tree is packed with the Sort-Tile-Recursive method on the x & y axes, and each node keeps the types of 
+	// the objects below it so that the type filtered queries skip the subtrees without matching object.
+	// The objects without envelope get the bounding box of their polygons & children, and are left out if there is none.
+	// The queries append their result to the given vector.
+	class SpatialIndex
+	{
+	public:
+		LIBCITYGML_EXPORT SpatialIndex( const CityModel& );
+
+		// Get the number of indexed objects
+		inline unsigned int size( void ) const { return _objects.size(); }
+
+		// Get the objects whose envelope intersects the box
+		LIBCITYGML_EXPORT void intersect( const Envelope& box, std::vector< const CityObject* >& result, CityObjectsTypeMask mask = COT_All ) const;
+
+		// Get the objects whose envelope contains the point
+		LIBCITYGML_EXPORT void contain( const TVec3d& point, std::vector< const CityObject* >& result, CityObjectsTypeMask mask = COT_All ) const;
+
+		// Get the k objects whose envelope is the nearest to the point, by increasing distance
+		LIBCITYGML_EXPORT void nearest( const TVec3d& point, unsigned int k, std::vector< const CityObject* >& result, CityObjectsTypeMask mask = COT_All ) const;
+
+	protected:
+		// The leaves cover a range of _objects, the other nodes a range of _nodes
+		class Node
+		{
+		public:
+			TVec3d lower, upper;
+			CityObjectsTypeMask types;
+			unsigned int first, count;
+		};
+
+		inline bool isLeaf( unsigned int node ) const { return node < _leavesCount; }
+
+	protected:
+		std::vector< const CityObject* > _objects;
+		std::vector< Envelope > _envelopes;		// of each object
+		std::vector< Node > _nodes;				// the leaves, then each upper level, the root last
+		unsigned int _leavesCount;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Polygons of the whole model sharing the same LOD & appearance, concatenated for rendering (see RenderBatches).
+	// Each vertex carries the id of its city object in the features table of the batches.
+	class RenderBatch
+	{
+		friend class RenderBatches;
+	public:
+		inline unsigned int getLOD( void ) const { return _lod; }
+
+		inline const Material* getMaterial( void ) const { return _material; }
+		inline const Texture* getTexture( void ) const { return _texture; }
+
+		// Default color of the polygons when the batch has neither material nor texture (see CityObject::getDefaultGeometryColor)
+		inline const TVec4f& getColor( void ) const { return _color; }
+
+		inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
+		inline const std::vector<TVec3f>& getNormals( void ) const { return _normals; }
+		inline const std::vector<TVec2f>& getTexCoords( void ) const { return _texCoords; }	// empty unless the batch has a texture
+		inline const std::vector<unsigned int>& getFeatureIds( void ) const { return _featureIds; }
+		inline const std::vector<unsigned int>& getIndices( void ) const { return _indices; }
+
+	protected:
+		RenderBatch( unsigned int lod, const Material* material, const Texture* texture, const TVec4f& color ) 
+			: _lod( lod ), _material( material ), _texture( texture ), _color( color ) {}
+
+	protected:
+		unsigned int _lod;
+		const Material* _material;
+		const Texture* _texture;
+		TVec4f _color;
+
+		std::vector<TVec3d> _vertices;
+		std::vector<TVec3f> _normals;
+		std::vector<TVec2f> _texCoords;
+		std::vector<unsigned int> _featureIds;
+		std::vector<unsigned int> _indices;
+	};
+
+	// City-wide render batches, built from a loaded model which must outlive them.
+	// The features table maps the vertices feature ids back to the city objects, eg. for picking.
+	class RenderBatches
+	{
+	public:
+		LIBCITYGML_EXPORT RenderBatches( const CityModel& );
+
+		inline unsigned int size( void ) const { return _batches.size(); }
+		inline const RenderBatch& operator[]( unsigned int i ) const { return _batches[i]; }
+
+		inline const std::vector< const CityObject* >& getFeatures( void ) const { return _features; }
+		inline const CityObject* getFeature( unsigned int id ) const { return ( id < _features.size() ) ? _features[id] : 0; }
+
+	protected:
+		std::vector< RenderBatch > _batches;
+		std::vector< const CityObject* > _features;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Texture atlas planning
+
+	// Parameters:
+	// texturesPath: directory where the relative texture urls are resolved, usually the directory of the CityGML file
+	// pageSize: maximal width & height in pixels of an atlas page, larger images are left out of the atlas
+	// padding: pixels around each image, to be filled with its edge texels so that filtering does not bleed between images
+	// groupByRoot: plan separate pages for each root object (eg. a building and its parts) rather than for the whole model
+
+	class AtlasParams
+	{
+	public:
+		AtlasParams( void ) : texturesPath( "" ), pageSize( 4096 ), padding( 2 ), groupByRoot( false ) {}
+
+	public:
+		std::string texturesPath;
+		unsigned int pageSize;
+		unsigned int padding;
+		bool groupByRoot;
+	};
+
+	// An image of the atlas, ie. a texture url of a group, and its placement in a page.
+	// The position is in pixels from the top-left corner of the page, padding excluded.
+	class AtlasImage
+	{
+	public:
+		enum Status
+		{
+			AS_Packed = 0,
+			AS_Unreadable,	// missing file or unknown format (only PNG, JPEG & TIFF headers are read)
+			AS_TooLarge,	// larger than a page
+			AS_Repeated		// sampled outside of [0,1], which the atlas cannot reproduce whatever the wrap mode, so it needs its own texture
+		};
+
+		AtlasImage( const std::string& url, const std::string& path, unsigned int group ) 
+			: url( url ), path( path ), group( group ), width( 0 ), height( 0 ), status( AS_Packed ), page( 0 ), x( 0 ), y( 0 ) {}
+
+	public:
+		std::string url;
+		std::string path;	// the resolved file path
+		unsigned int group;
+		unsigned int width, height;
+		Status status;
+		unsigned int page, x, y;	// only meaningful when packed
+	};
+
+	class AtlasPage
+	{
+	public:
+		AtlasPage( unsigned int group ) : group( group ), width( 0 ), height( 0 ) {}
+
+	public:
+		unsigned int group;
+		unsigned int width, height;
+		std::vector< unsigned int > images;
+	};
+
+	// Plan the packing of the model textures into atlas pages, and remap the texture coordinates of 
+	// the polygons whose image is packed into their page space. The model must outlive the atlas.
+	// The pages are not composited: the plan gives where to copy each image (see AtlasImage).
+	class TextureAtlas
+	{
+	public:
+		LIBCITYGML_EXPORT TextureAtlas( CityModel&, const AtlasParams& );
+
+		inline const std::vector< AtlasPage >& getPages( void ) const { return _pages; }
+		inline const std::vector< AtlasImage >& getImages( void ) const { return _images; }
+
+		// Root object of a group, null when the groups are not split by root
+		inline const CityObject* getGroupRoot( unsigned int group ) const { return ( group < _groups.size() ) ? _groups[group] : 0; }
+
+		// Get the image of a textured polygon, its texture coordinates are in its page space if the image is packed
+		inline const AtlasImage* getImage( const Polygon* p ) const
+		{
+			std::unordered_map< const Polygon*, unsigned int >::const_iterator it = _polygons.find( p );
+			return ( it != _polygons.end() ) ? &_images[ it->second ] : 0;
+		}
+
+		// Read the size of a PNG, JPEG or TIFF image from its header, without decoding it
+		LIBCITYGML_EXPORT static bool readImageSize( const std::string& path, unsigned int& width, unsigned int& height );
+
+	protected:
+		void pack( unsigned int group, const AtlasParams& );
+
+	protected:
+		std::vector< const CityObject* > _groups;
+		std::vector< AtlasPage > _pages;
+		std::vector< AtlasImage > _images;
+		std::unordered_map< const Polygon*, unsigned int > _polygons;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Memory mapped binary models
+
+	namespace binary
+	{
+		struct AppearanceRecord;
+		struct ObjectRecord;
+		struct GeometryRecord;
+		struct PolygonRecord;
+		struct ModelRecord;
+		struct AttributeRecord;
+		struct SourceRecord;
+	}
+
+	// The mapped views mirror the navigation API of the model classes, but are small handles to pass by value,
+	// reading the records of the mapped file in place. They are only valid while their model is mapped.
+	// The references between records are checked when followed, a damaged one giving an empty or invalid view: the polygon
+	// indices against their vertices on each access, and the children & roots so that the objects hierarchy walked from
+	// them is a forest (the objects are saved in pre-order, which makes that check constant time).
+
+	class MappedObject
+	{
+	public:
+		// Whether the view refers to a record, eg. a polygon may have no texture
+		inline bool isValid( void ) const { return _model != 0; }
+
+		LIBCITYGML_EXPORT const char* getId( void ) const;
+
+		LIBCITYGML_EXPORT unsigned int getAttributesCount( void ) const;
+		LIBCITYGML_EXPORT const char* getAttributeName( unsigned int i ) const;
+		LIBCITYGML_EXPORT AttributeValue getAttributeValue( unsigned int i ) const;
+
+		// Get the text of an attribute, or the default value when it is missing
+		LIBCITYGML_EXPORT const char* getAttribute( const std::string& name, const char* defvalue = "" ) const;
+
+	protected:
+		MappedObject( const MappedCityModel* model, unsigned int id, unsigned int attributesFirst, unsigned int attributesCount ) 
+			: _model( model ), _id( id ), _attributesFirst( attributesFirst ), _attributesCount( attributesCount ) {}
+
+	protected:
+		const MappedCityModel* _model;
+		unsigned int _id;
+		unsigned int _attributesFirst, _attributesCount;
+	};
+
+	// A material or a texture
+	class MappedAppearance : public MappedObject
+	{
+	public:
+		LIBCITYGML_EXPORT MappedAppearance( const MappedCityModel* model = 0, unsigned int index = 0xFFFFFFFF );
+
+		// "Material", "Texture" or "GeoreferencedTexture"
+		LIBCITYGML_EXPORT const char* getType( void ) const;
+
+		LIBCITYGML_EXPORT bool isMaterial( void ) const;
+		LIBCITYGML_EXPORT bool isTexture( void ) const;
+
+		LIBCITYGML_EXPORT bool getIsFront( void ) const;
+
+		LIBCITYGML_EXPORT TVec3f getDiffuse( void ) const;
+		LIBCITYGML_EXPORT TVec3f getEmissive( void ) const;
+		LIBCITYGML_EXPORT TVec3f getSpecular( void ) const;
+		LIBCITYGML_EXPORT float getAmbientIntensity( void ) const;
+		LIBCITYGML_EXPORT float getShininess( void ) const;
+		LIBCITYGML_EXPORT float getTransparency( void ) const;
+
+		LIBCITYGML_EXPORT const char* getUrl( void ) const;
+		LIBCITYGML_EXPORT bool getRepeat( void ) const;
+		LIBCITYGML_EXPORT Texture::WrapMode getWrapMode( void ) const;
+		LIBCITYGML_EXPORT TVec4f getBorderColor( void ) const;
+
+	protected:
+		const binary::AppearanceRecord* _record;
+	};
+
+	class MappedPolygon : public MappedObject
+	{
+	public:
+		LIBCITYGML_EXPORT MappedPolygon( const MappedCityModel* model = 0, unsigned int index = 0xFFFFFFFF );
+
+		// The geometry data, read in place from the mapped file
+		LIBCITYGML_EXPORT ArrayView<TVec3d> getVertices( void ) const;
+		LIBCITYGML_EXPORT ArrayView<unsigned int> getIndices( void ) const;
+		LIBCITYGML_EXPORT ArrayView<TVec3f> getNormals( void ) const;
+		LIBCITYGML_EXPORT ArrayView<TVec2f> getTexCoords( void ) const;
+
+		LIBCITYGML_EXPORT bool hasUniformNormal( void ) const;
+		LIBCITYGML_EXPORT TVec3f getNormal( void ) const;
+
+		LIBCITYGML_EXPORT MappedAppearance getAppearance( void ) const;
+		LIBCITYGML_EXPORT MappedAppearance getMaterial( void ) const;
+		LIBCITYGML_EXPORT MappedAppearance getMaterialFront( void ) const;
+		LIBCITYGML_EXPORT MappedAppearance getMaterialBack( void ) const;
+		LIBCITYGML_EXPORT MappedAppearance getTexture( void ) const;
+
+		// The source polygons of a merged polygon (see Polygon::getSources)
+		LIBCITYGML_EXPORT unsigned int getSourcesCount( void ) const;
+		LIBCITYGML_EXPORT PolygonRange getSource( unsigned int i ) const;
+
+	protected:
+		const binary::PolygonRecord* _record;
+	};
+
+	class MappedGeometry : public MappedObject
+	{
+	public:
+		LIBCITYGML_EXPORT MappedGeometry( const MappedCityModel* model = 0, unsigned int index = 0xFFFFFFFF );
+
+		LIBCITYGML_EXPORT GeometryType getType( void ) const;
+		LIBCITYGML_EXPORT unsigned int getLOD( void ) const;
+
+		// Get the number of polygons
+		LIBCITYGML_EXPORT unsigned int size( void ) const;
+		LIBCITYGML_EXPORT MappedPolygon operator[]( unsigned int i ) const;
+
+	protected:
+		const binary::GeometryRecord* _record;
+	};
+
+	class MappedCityObject : public MappedObject
+	{
+	public:
+		LIBCITYGML_EXPORT MappedCityObject( const MappedCityModel* model = 0, unsigned int index = 0xFFFFFFFF );
+
+		LIBCITYGML_EXPORT CityObjectsType getType( void ) const;
+		inline std::string getTypeAsString( void ) const { return getCityObjectsClassName( getType() ); }
+
+		LIBCITYGML_EXPORT Envelope getEnvelope( void ) const;
+
+		// Get the number of geometries
+		LIBCITYGML_EXPORT unsigned int size( void ) const;
+		LIBCITYGML_EXPORT MappedGeometry getGeometry( unsigned int i ) const;
+
+		LIBCITYGML_EXPORT unsigned int getChildCount( void ) const;
+		LIBCITYGML_EXPORT MappedCityObject getChild( unsigned int i ) const;
+
+	protected:
+		const binary::ObjectRecord* _record;
+	};
+
+	// A binary model file (see save_binary) mapped in memory. Opening it only reads its blocks directory:
+	// the records are read in place when the views are used, so only the touched pages become resident,
+	// and the processes mapping the same file share its page cache copy.
+	class MappedCityModel : public MappedObject
+	{
+		friend class MappedObject;
+		friend class MappedAppearance;
+		friend class MappedPolygon;
+		friend class MappedGeometry;
+		friend class MappedCityObject;
+		friend class ModelSerializer;
+	public:
+		LIBCITYGML_EXPORT ~MappedCityModel( void );
+
+		LIBCITYGML_EXPORT Envelope getEnvelope( void ) const;
+
+		LIBCITYGML_EXPORT TVec3d getTranslationParameters( void ) const;
+
+		LIBCITYGML_EXPORT const char* getSRSName( void ) const;
+
+		// Get the number of city objects
+		inline unsigned int size( void ) const { return _objects.count; }
+		inline MappedCityObject getCityObject( unsigned int i ) const { return MappedCityObject( this, i ); }
+
+		LIBCITYGML_EXPORT std::vector< MappedCityObject > getCityObjectsByType( CityObjectsTypeMask mask ) const;
+
+		// Return the roots elements of the model, the hierarchy is then navigated with getChild()
+		inline unsigned int getRootsCount( void ) const { return _roots.count; }
+		LIBCITYGML_EXPORT MappedCityObject getRoot( unsigned int i ) const;
+
+	protected:
+		MappedCityModel( void );
+
+		// Map the file, check its header & blocks directory
+		bool open( const std::string& fileName );
+
+		const char* getString( unsigned int i ) const;
+
+		template< class T > class Block
+		{
+		public:
+			Block( void ) : data( 0 ), count( 0 ) {}
+
+			inline const T* at( unsigned int i ) const { return ( i < count ) ? data + i : 0; }
+
+		public:
+			const T* data;
+			unsigned int count;
+		};
+
+	private:
+		MappedCityModel( const MappedCityModel& );
+		MappedCityModel& operator=( const MappedCityModel& );
+
+	protected:
+		char* _data;
+		size_t _size;
+
+		Block< unsigned long long > _stringsOffsets;
+		const char* _chars;
+		size_t _charsSize;
+
+		const binary::ModelRecord* _record;
+		Block< binary::AttributeRecord > _attributes;
+		Block< binary::AppearanceRecord > _appearances;
+		Block< binary::ObjectRecord > _objects;
+		Block< unsigned int > _children;
+		Block< unsigned int > _roots;
+		Block< binary::GeometryRecord > _geometries;
+		Block< binary::PolygonRecord > _polygons;
+		Block< binary::SourceRecord > _sources;
+		Block< TVec3d > _vertices;
+		Block< TVec2f > _texCoords;
+		Block< unsigned int > _indices;
+		Block< TVec3f > _normals;
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	std::ostream& operator<<( std::ostream&, const citygml::Envelope& );
+	std::ostream& operator<<( std::ostream&, const citygml::Object& );
+	std::ostream& operator<<( std::ostream&, const citygml::Geometry& );
+	std::ostream& operator<<( std::ostream&, const citygml::CityObject& );
+	std::ostream& operator<<( std::ostream&, const citygml::CityModel & );
+	std::ostream& operator<<( std::ostream&, const citygml::TextureAtlas & );
+}
+
+#endif // __CITYGML_H__
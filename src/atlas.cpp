@@ -0,0 +1,313 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "citygml.h"
+#include <fstream>
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace citygml
+{
+	///////////////////////////////////////////////////////////////////////////////
+	// Image headers
+
+	static inline unsigned int readUInt( const unsigned char* p, unsigned int size, bool bigEndian )
+	{
+		unsigned int v = 0;
+		for ( unsigned int i = 0; i < size; i++ ) v |= (unsigned int)p[ bigEndian ? i : size - 1 - i ] << ( 8 * ( size - 1 - i ) );
+		return v;
+	}
+
+	static bool readPNGSize( std::istream& in, unsigned int& width, unsigned int& height )
+	{
+		// Signature, then the IHDR chunk which must come first: length, type, width, height
+		unsigned char h[24];
+		in.seekg( 0 );
+		if ( !in.read( (char*)h, 24 ) || memcmp( h, "\x89PNG\r\n\x1a\n", 8 ) != 0 || memcmp( h + 12, "IHDR", 4 ) != 0 ) return false;
+		width = readUInt( h + 16, 4, true );
+		height = readUInt( h + 20, 4, true );
+		return true;
+	}
+
+	static bool readJPEGSize( std::istream& in, unsigned int& width, unsigned int& height )
+	{
+		unsigned char h[8];
+		in.seekg( 0 );
+		if ( !in.read( (char*)h, 2 ) || h[0] != 0xFF || h[1] != 0xD8 ) return false;
+
+		// Walk the segments up to the start of frame one
+		while ( in.read( (char*)h, 2 ) )
+		{
+			if ( h[0] != 0xFF ) return false;
+			unsigned char marker = h[1];
+			if ( marker == 0xFF ) { in.seekg( -1, std::ios::cur ); continue; } // fill byte
+			if ( marker == 0x01 || ( marker >= 0xD0 && marker <= 0xD8 ) ) continue; // no payload
+			if ( marker == 0xD9 || marker == 0xDA ) return false; // end of image or scan before any frame
+
+			if ( !in.read( (char*)h, 2 ) ) return false;
+			unsigned int length = readUInt( h, 2, true );
+			if ( length < 2 ) return false;
+
+			// SOF0..SOF15 but DHT (C4), JPG (C8) & DAC (CC): precision, height, width
+			if ( marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC )
+			{
+				if ( !in.read( (char*)h, 5 ) ) return false;
+				height = readUInt( h + 1, 2, true );
+				width = readUInt( h + 3, 2, true );
+				return true;
+			}
+			in.seekg( length - 2, std::ios::cur );
+		}
+		return false;
+	}
+
+	static bool readTIFFSize( std::istream& in, unsigned int& width, unsigned int& height )
+	{
+		unsigned char h[12];
+		in.seekg( 0 );
+		if ( !in.read( (char*)h, 8 ) ) return false;
+
+		bool bigEndian;
+		if ( h[0] == 'I' && h[1] == 'I' ) bigEndian = false;
+		else if ( h[0] == 'M' && h[1] == 'M' ) bigEndian = true;
+		else return false;
+		if ( readUInt( h + 2, 2, bigEndian ) != 42 ) return false; // BigTIFF is not supported
+
+		// The first IFD holds the ImageWidth (256) & ImageLength (257) tags, as SHORT (3) or LONG (4)
+		in.seekg( readUInt( h + 4, 4, bigEndian ) );
+		if ( !in.read( (char*)h, 2 ) ) return false;
+		unsigned int count = readUInt( h, 2, bigEndian );
+
+		width = height = 0;
+		for ( unsigned int i = 0; i < count && in.read( (char*)h, 12 ); i++ )
+		{
+			unsigned int tag = readUInt( h, 2, bigEndian );
+			if ( tag != 256 && tag != 257 ) continue;
+			unsigned int type = readUInt( h + 2, 2, bigEndian );
+			unsigned int value = ( type == 3 ) ? readUInt( h + 8, 2, bigEndian ) : readUInt( h + 8, 4, bigEndian );
+			( tag == 256 ? width : height ) = value;
+		}
+		return width > 0 && height > 0;
+	}
+
+	bool TextureAtlas::readImageSize( const std::string& path, unsigned int& width, unsigned int& height )
+	{
+		std::ifstream in( path.c_str(), std::ios::in | std::ios::binary );
+		if ( !in ) return false;
+
+		if ( readPNGSize( in, width, height ) ) return true;
+		in.clear();
+		if ( readJPEGSize( in, width, height ) ) return true;
+		in.clear();
+		return readTIFFSize( in, width, height );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+	// Atlas planning
+
+	static std::string resolveTexturePath( const std::string& url, const std::string& dir )
+	{
+		std::string path = url;
+		if ( path.compare( 0, 7, "file://" ) == 0 ) path = path.substr( 7 );
+
+		bool absolute = path.empty() || path[0] == '/' || path[0] == '\\' || ( path.size() > 1 && path[1] == ':' ) || path.find( "://" ) != std::string::npos;
+		if ( absolute || dir.empty() ) return path;
+
+		char last = dir[ dir.size() - 1 ];
+		return ( last == '/' || last == '\\' ) ? dir + path : dir + "/" + path;
+	}
+
+	static void collectPolygons( const CityObject* obj, std::vector< Polygon* >& polygons )
+	{
+		for ( unsigned int i = 0; i < obj->size(); i++ )
+		{
+			const Geometry* geom = obj->getGeometry( i );
+			for ( unsigned int j = 0; j < geom->size(); j++ )
+				if ( (*geom)[j]->getTexture() ) polygons.push_back( const_cast< Polygon* >( (*geom)[j] ) );
+		}
+
+		for ( unsigned int i = 0; i < obj->getChildCount(); i++ ) collectPolygons( obj->getChild( i ), polygons );
+	}
+
+	TextureAtlas::TextureAtlas( CityModel& model, const AtlasParams& params )
+	{
+		const CityObjects& roots = model.getCityObjectsRoots();
+		unsigned int groupsCount = params.groupByRoot ? roots.size() : 1;
+		if ( params.groupByRoot ) _groups.assign( roots.begin(), roots.end() );
+
+		// The sampling tolerance around [0,1], for the rounding of the parsed coordinates
+		const float eps = 1e-3f;
+
+		// Largest image fitting in a page with its padding, 0 if the padding alone does not fit
+		const unsigned int room = ( params.pageSize > 0 && params.padding <= ( params.pageSize - 1 ) / 2 ) ? params.pageSize - 2 * params.padding : 0;
+
+		// Image sizes, by resolved path since many textures of different groups share the same file
+		std::unordered_map< std::string, std::pair< unsigned int, unsigned int > > sizes;
+
+		std::vector< Polygon* > polygons;
+		for ( unsigned int g = 0; g < groupsCount; g++ )
+		{
+			polygons.clear();
+			if ( params.groupByRoot ) collectPolygons( roots[g], polygons );
+			else for ( unsigned int i = 0; i < roots.size(); i++ ) collectPolygons( roots[i], polygons );
+
+			// One image per texture url of the group
+			std::unordered_map< std::string, unsigned int > images;
+			unsigned int first = _images.size();
+			for ( unsigned int i = 0; i < polygons.size(); i++ )
+			{
+				Polygon* p = polygons[i];
+				ArrayView<TVec2f> texCoords = p->getTexCoords();
+				if ( texCoords.size() == 0 ) continue;
+
+				const Texture* texture = p->getTexture();
+				std::pair< std::unordered_map< std::string, unsigned int >::iterator, bool > ins = images.insert( std::make_pair( texture->getUrl(), (unsigned int)_images.size() ) );
+				if ( ins.second ) _images.push_back( AtlasImage( texture->getUrl(), resolveTexturePath( texture->getUrl(), params.texturesPath ), g ) );
+				AtlasImage& image = _images[ ins.first->second ];
+				_polygons[ p ] = ins.first->second;
+
+				// An atlas can neither repeat an image nor clamp its sampling beyond the padding, even in the clamp wrap mode
+				if ( image.status != AtlasImage::AS_Packed ) continue;
+				for ( unsigned int k = 0; k < texCoords.size(); k++ )
+				{
+					const TVec2f& t = texCoords[k];
+					if ( t.x < -eps || t.x > 1.f + eps || t.y < -eps || t.y > 1.f + eps ) { image.status = AtlasImage::AS_Repeated; break; }
+				}
+			}
+
+			for ( unsigned int i = first; i < _images.size(); i++ )
+			{
+				AtlasImage& image = _images[i];
+
+				std::unordered_map< std::string, std::pair< unsigned int, unsigned int > >::iterator it = sizes.find( image.path );
+				if ( it == sizes.end() )
+				{
+					std::pair< unsigned int, unsigned int > size( 0, 0 );
+					if ( !readImageSize( image.path, size.first, size.second ) ) size = std::make_pair( 0u, 0u );
+					it = sizes.insert( std::make_pair( image.path, size ) ).first;
+				}
+				image.width = it->second.first;
+				image.height = it->second.second;
+
+				if ( image.status != AtlasImage::AS_Packed ) continue;
+				if ( image.width == 0 || image.height == 0 ) image.status = AtlasImage::AS_Unreadable;
+				else if ( image.width > room || image.height > room ) image.status = AtlasImage::AS_TooLarge;
+			}
+
+			pack( g, params );
+		}
+
+		// Remap the texture coordinates of the packed images into their page space,
+		// the pixel rows being counted from the top while the coordinates start at the bottom
+		std::unordered_map< const Polygon*, unsigned int >::const_iterator it = _polygons.begin();
+		for ( ; it != _polygons.end(); ++it )
+		{
+			const AtlasImage& image = _images[ it->second ];
+			if ( image.status != AtlasImage::AS_Packed ) continue;
+
+			const AtlasPage& page = _pages[ image.page ];
+			Polygon* p = const_cast< Polygon* >( it->first );
+			unsigned int count = p->getTexCoords().size();
+			TVec2f* texCoords = p->getTexCoordsData( model._arena );
+			for ( unsigned int k = 0; k < count; k++ )
+			{
+				texCoords[k].x = ( image.x + texCoords[k].x * image.width ) / page.width;
+				texCoords[k].y = 1.f - ( image.y + ( 1.f - texCoords[k].y ) * image.height ) / page.height;
+			}
+		}
+	}
+
+	// Shelf packing of the images of a group, by decreasing height: each image goes on the first shelf
+	// where it fits, or on a new shelf of the first page having room left, or else on a new page
+	void TextureAtlas::pack( unsigned int group, const AtlasParams& params )
+	{
+		std::vector< unsigned int > order;
+		for ( unsigned int i = 0; i < _images.size(); i++ )
+			if ( _images[i].group == group && _images[i].status == AtlasImage::AS_Packed ) order.push_back( i );
+
+		std::sort( order.begin(), order.end(), [this]( unsigned int a, unsigned int b )
+		{
+			if ( _images[a].height != _images[b].height ) return _images[a].height > _images[b].height;
+			if ( _images[a].width != _images[b].width ) return _images[a].width > _images[b].width;
+			return a < b;
+		} );
+
+		struct Shelf
+		{
+			unsigned int page, y, height, width;
+		};
+		std::vector< Shelf > shelves;
+		unsigned int firstPage = _pages.size();
+
+		for ( unsigned int i = 0; i < order.size(); i++ )
+		{
+			AtlasImage& image = _images[ order[i] ];
+			unsigned int w = image.width + 2 * params.padding;
+			unsigned int h = image.height + 2 * params.padding;
+
+			unsigned int s = 0;
+			while ( s < shelves.size() && ( h > shelves[s].height || shelves[s].width + w > params.pageSize ) ) s++;
+
+			if ( s == shelves.size() )
+			{
+				unsigned int p = firstPage;
+				while ( p < _pages.size() && _pages[p].height + h > params.pageSize ) p++;
+				if ( p == _pages.size() ) _pages.push_back( AtlasPage( group ) );
+
+				Shelf shelf = { p, _pages[p].height, h, 0 };
+				shelves.push_back( shelf );
+				_pages[p].height += h;
+			}
+
+			Shelf& shelf = shelves[s];
+			AtlasPage& page = _pages[ shelf.page ];
+			image.page = shelf.page;
+			image.x = shelf.width + params.padding;
+			image.y = shelf.y + params.padding;
+			shelf.width += w;
+			page.width = std::max( page.width, shelf.width );
+			page.images.push_back( order[i] );
+		}
+	}
+
+	std::ostream& operator<<( std::ostream& out, const TextureAtlas& atlas )
+	{
+		const std::vector< AtlasPage >& pages = atlas.getPages();
+		const std::vector< AtlasImage >& images = atlas.getImages();
+
+		for ( unsigned int i = 0; i < pages.size(); i++ )
+		{
+			const AtlasPage& page = pages[i];
+			out << "Page " << i << ": " << page.width << "x" << page.height;
+			if ( const CityObject* root = atlas.getGroupRoot( page.group ) ) out << " (" << root->getId() << ")";
+			out << std::endl;
+
+			for ( unsigned int j = 0; j < page.images.size(); j++ )
+			{
+				const AtlasImage& image = images[ page.images[j] ];
+				out << "  " << image.x << "," << image.y << " " << image.width << "x" << image.height << " " << image.url << std::endl;
+			}
+		}
+
+		static const char* reasons[] = { "packed", "unreadable", "too large", "repeated" };
+		for ( unsigned int i = 0; i < images.size(); i++ )
+			if ( images[i].status != AtlasImage::AS_Packed )
+				out << "Not packed (" << reasons[ images[i].status ] << "): " << images[i].url << std::endl;
+
+		return out;
+	}
+}
@@ -0,0 +1,940 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "citygml.h"
+#include "binaryformat.h"
+#include <fstream>
+#include <chrono>
+#include <string.h>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#ifdef WIN32
+#	include <direct.h>
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
+static_assert( sizeof( TVec3d ) == 3 * sizeof( double ) && sizeof( TVec3f ) == 3 * sizeof( float ) && sizeof( TVec2f ) == 2 * sizeof( float ), "unexpected vectors layout" );
+static_assert( sizeof( unsigned int ) == sizeof( uint32_t ), "unexpected indices size" );
+
+namespace citygml
+{
+	using namespace binary;
+
+	uint64_t binary::getRecordSize( BlockType type )
+	{
+		switch ( type )
+		{
+		case BT_Model: return sizeof( ModelRecord );
+		case BT_Attributes: return sizeof( AttributeRecord );
+		case BT_Appearances: return sizeof( AppearanceRecord );
+		case BT_Objects: return sizeof( ObjectRecord );
+		case BT_Children:
+		case BT_Roots:
+		case BT_Indices: return sizeof( uint32_t );
+		case BT_Geometries: return sizeof( GeometryRecord );
+		case BT_Polygons: return sizeof( PolygonRecord );
+		case BT_Sources: return sizeof( SourceRecord );
+		case BT_Vertices: return sizeof( TVec3d );
+		case BT_TexCoords: return sizeof( TVec2f );
+		case BT_Normals: return sizeof( TVec3f );
+		default: return 0;
+		}
+	}
+
+	bool binary::checkHeader( const FileHeader& header, uint64_t fileSize )
+	{
+		if ( fileSize < sizeof( header ) || memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0 || header.version != VERSION ) return false;
+		return header.blocksCount > 0 && header.blocksCount <= ( fileSize - sizeof( header ) ) / sizeof( BlockEntry );
+	}
+
+	bool binary::findBlocks( const BlockEntry* entries, uint32_t count, uint64_t fileSize, const BlockEntry* blocks[ BT_Count ] )
+	{
+		for ( unsigned int i = 0; i < BT_Count; i++ ) blocks[i] = 0;
+
+		for ( unsigned int i = 0; i < count; i++ )
+		{
+			const BlockEntry& e = entries[i];
+			if ( e.type >= BT_Count ) continue; // unknown blocks are skipped
+			if ( e.offset > fileSize || e.size > fileSize - e.offset || e.offset % 8 != 0 ) return false;
+			if ( e.type != BT_Strings && e.size != e.count * getRecordSize( (BlockType)e.type ) ) return false;
+			blocks[ e.type ] = &e;
+		}
+
+		for ( unsigned int i = 0; i < BT_Count; i++ ) if ( !blocks[i] ) return false;
+		return blocks[ BT_Model ]->count == 1 && blocks[ BT_Strings ]->size >= ( blocks[ BT_Strings ]->count + 1ULL ) * sizeof( uint64_t );
+	}
+
+	bool binary::checkHierarchy( const ObjectRecord* objects, uint32_t objectsCount, const uint32_t* children, uint64_t childrenCount, const uint32_t* roots, uint64_t rootsCount )
+	{
+		for ( uint32_t i = 0; i < objectsCount; i++ )
+		{
+			const ObjectRecord& r = objects[i];
+			if ( !checkRange( r.childrenFirst, r.childrenCount, childrenCount ) ) return false;
+			for ( uint32_t k = 0; k < r.childrenCount; k++ ) if ( !checkListed( objects, objectsCount, i, children + r.childrenFirst, k ) ) return false;
+		}
+		for ( uint32_t k = 0; k < rootsCount; k++ ) if ( !checkListed( objects, objectsCount, NONE, roots, k ) ) return false;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Content of a binary model file, but for the strings
+	struct BinaryModel
+	{
+		ModelRecord model;
+		std::vector< AttributeRecord > attributes;
+		std::vector< AppearanceRecord > appearances;
+		std::vector< ObjectRecord > objects;
+		std::vector< uint32_t > children;
+		std::vector< uint32_t > roots;
+		std::vector< GeometryRecord > geometries;
+		std::vector< PolygonRecord > polygons;
+		std::vector< SourceRecord > sources;
+	};
+
+	// Strings table of a file being written, each distinct string is stored once
+	class StringTable
+	{
+	public:
+		inline uint32_t add( const std::string& s )
+		{
+			std::pair< std::unordered_map< std::string, uint32_t >::iterator, bool > ins = _indices.insert( std::make_pair( s, (uint32_t)_strings.size() ) );
+			if ( ins.second ) _strings.push_back( &ins.first->first );
+			return ins.first->second;
+		}
+
+		inline uint32_t size( void ) const { return _strings.size(); }
+
+		// The block payload: the offsets then the null terminated strings
+		void write( std::vector< char >& payload ) const
+		{
+			std::vector< uint64_t > offsets( 1, 0 );
+			for ( unsigned int i = 0; i < _strings.size(); i++ ) offsets.push_back( offsets.back() + _strings[i]->size() + 1 );
+
+			payload.resize( offsets.size() * sizeof( uint64_t ) );
+			memcpy( &payload[0], &offsets[0], payload.size() );
+			for ( unsigned int i = 0; i < _strings.size(); i++ ) payload.insert( payload.end(), _strings[i]->c_str(), _strings[i]->c_str() + _strings[i]->size() + 1 );
+		}
+
+	private:
+		std::unordered_map< std::string, uint32_t > _indices;
+		std::vector< const std::string* > _strings;
+	};
+
+	static std::string toHex( uint64_t v )
+	{
+		char buffer[17];
+		sprintf( buffer, "%016llx", (unsigned long long)v );
+		return buffer;
+	}
+
+	// Move a file over another one, which is replaced as a whole
+	static bool replaceFile( const std::string& from, const std::string& to )
+	{
+		if ( rename( from.c_str(), to.c_str() ) == 0 ) return true;
+
+		// Windows does not replace an existing file
+		remove( to.c_str() );
+		return rename( from.c_str(), to.c_str() ) == 0;
+	}
+
+	static void setEnvelope( double* dst, const Envelope& e )
+	{
+		for ( unsigned int i = 0; i < 3; i++ ) { dst[i] = e.getLowerBound()[i]; dst[ 3 + i ] = e.getUpperBound()[i]; }
+	}
+
+	static void addAttributes( const AttributesMap& attributes, StringTable& strings, std::vector< AttributeRecord >& records, uint32_t& first, uint32_t& count )
+	{
+		first = records.size();
+		count = attributes.size();
+		for ( AttributesMap::const_iterator it = attributes.begin(); it != attributes.end(); ++it )
+		{
+			AttributeRecord r;
+			r.name = strings.add( it->first.str() );
+			r.text = strings.add( it->second.asString() );
+			r.type = it->second.getType();
+			r.reserved = 0;
+			r.value = ModelSerializer::getRawValue( it->second );
+			records.push_back( r );
+		}
+	}
+
+	bool ModelSerializer::save( const CityModel& model, const std::string& fileName, const SourceKey* key )
+	{
+		if ( !isLittleEndianHost() )
+		{
+			std::cerr << "CityGML: Binary models are only supported on little-endian hosts!" << std::endl;
+			return false;
+		}
+
+		BinaryModel b;
+		StringTable strings;
+		std::vector< TVec3d > vertices;
+		std::vector< TVec2f > texCoords;
+		std::vector< unsigned int > indices;
+		std::vector< TVec3f > normals;
+
+		b.model.id = strings.add( model._id );
+		b.model.srsName = strings.add( model._srsName );
+		addAttributes( model._attributes, strings, b.attributes, b.model.attributesFirst, b.model.attributesCount );
+		setEnvelope( b.model.envelope, model._envelope );
+		for ( unsigned int i = 0; i < 3; i++ ) b.model.translation[i] = model._translation[i];
+
+		// Appearances
+		const std::vector< Appearance* >& appearances = model._appearanceManager._appearances;
+		std::unordered_map< const Appearance*, uint32_t > appearanceIndices;
+		for ( unsigned int i = 0; i < appearances.size(); i++ )
+		{
+			const Appearance* app = appearances[i];
+			appearanceIndices[ app ] = i;
+
+			AppearanceRecord r;
+			memset( &r, 0, sizeof( r ) );
+			r.id = strings.add( app->_id );
+			r.isFront = app->_isFront;
+			addAttributes( app->_attributes, strings, b.attributes, r.attributesFirst, r.attributesCount );
+			r.url = strings.add( "" );
+
+			if ( const Texture* tex = dynamic_cast< const Texture* >( app ) )
+			{
+				const GeoreferencedTexture* geoTex = dynamic_cast< const GeoreferencedTexture* >( tex );
+				r.kind = geoTex ? AK_GeoreferencedTexture : AK_Texture;
+				r.url = strings.add( tex->_url.str() );
+				r.repeat = tex->_repeat;
+				r.wrapMode = tex->_wrapMode;
+				r.preferWorldFile = geoTex ? geoTex->_preferWorldFile : 0;
+				for ( unsigned int k = 0; k < 4; k++ ) r.borderColor[k] = tex->_borderColor.rgba[k];
+			}
+			else if ( const Material* mat = dynamic_cast< const Material* >( app ) )
+			{
+				r.kind = AK_Material;
+				for ( unsigned int k = 0; k < 3; k++ )
+				{
+					r.diffuse[k] = mat->_diffuse[k];
+					r.emissive[k] = mat->_emissive[k];
+					r.specular[k] = mat->_specular[k];
+				}
+				r.ambientIntensity = mat->_ambientIntensity;
+				r.shininess = mat->_shininess;
+				r.transparency = mat->_transparency;
+			}
+			b.appearances.push_back( r );
+		}
+
+		// Objects in pre-order from the roots, then those out of their reach, with their geometries & polygons stored contiguously in that order
+		std::unordered_map< const CityObject*, uint32_t > objectIndices;
+		for ( CityObjectsMap::const_iterator it = model._cityObjectsMap.begin(); it != model._cityObjectsMap.end(); ++it )
+			for ( unsigned int i = 0; i < it->second.size(); i++ ) objectIndices[ it->second[i] ] = NONE;
+
+		std::vector< const CityObject* > objects;
+		std::vector< uint32_t > parents;
+		std::vector< std::pair< const CityObject*, uint32_t > > stack;
+		for ( unsigned int i = model._roots.size(); i > 0; i-- ) stack.push_back( std::make_pair( model._roots[ i - 1 ], NONE ) );
+		while ( !stack.empty() )
+		{
+			const CityObject* obj = stack.back().first;
+			uint32_t parent = stack.back().second;
+			stack.pop_back();
+
+			std::unordered_map< const CityObject*, uint32_t >::iterator it = objectIndices.find( obj );
+			if ( it == objectIndices.end() || it->second != NONE ) continue;
+			it->second = objects.size();
+			objects.push_back( obj );
+			parents.push_back( parent );
+			for ( unsigned int j = obj->_children.size(); j > 0; j-- ) stack.push_back( std::make_pair( obj->_children[ j - 1 ], it->second ) );
+		}
+
+		for ( CityObjectsMap::const_iterator it = model._cityObjectsMap.begin(); it != model._cityObjectsMap.end(); ++it )
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+			{
+				uint32_t& index = objectIndices[ it->second[i] ];
+				if ( index != NONE ) continue;
+				index = objects.size();
+				objects.push_back( it->second[i] );
+				parents.push_back( NONE );
+			}
+
+		for ( unsigned int i = 0; i < objects.size(); i++ )
+		{
+			const CityObject* obj = objects[i];
+
+			ObjectRecord r;
+			r.type = obj->_type;
+			r.id = strings.add( obj->_id );
+			addAttributes( obj->_attributes, strings, b.attributes, r.attributesFirst, r.attributesCount );
+			setEnvelope( r.envelope, obj->_envelope );
+
+			// Only the children reached from this object, which follow it in increasing order
+			r.childrenFirst = b.children.size();
+			for ( unsigned int j = 0; j < obj->_children.size(); j++ )
+			{
+				std::unordered_map< const CityObject*, uint32_t >::const_iterator c = objectIndices.find( obj->_children[j] );
+				if ( c != objectIndices.end() && parents[ c->second ] == i && ( b.children.size() == r.childrenFirst || c->second > b.children.back() ) ) b.children.push_back( c->second );
+			}
+			r.childrenCount = b.children.size() - r.childrenFirst;
+			r.parent = parents[i];
+			r.reserved = 0;
+
+			r.geometriesFirst = b.geometries.size();
+			r.geometriesCount = obj->_geometries.size();
+			for ( unsigned int j = 0; j < obj->_geometries.size(); j++ )
+			{
+				const Geometry* geom = obj->_geometries[j];
+
+				GeometryRecord g;
+				g.id = strings.add( geom->_id );
+				g.type = geom->_type;
+				g.lod = geom->_lod;
+				g.object = i;
+				addAttributes( geom->_attributes, strings, b.attributes, g.attributesFirst, g.attributesCount );
+				g.polygonsFirst = b.polygons.size();
+				g.polygonsCount = geom->_polygons.size();
+
+				for ( unsigned int k = 0; k < geom->_polygons.size(); k++ )
+				{
+					const Polygon* p = geom->_polygons[k];
+
+					PolygonRecord pr;
+					pr.id = strings.add( p->_id );
+					pr.geometry = b.geometries.size();
+					addAttributes( p->_attributes, strings, b.attributes, pr.attributesFirst, pr.attributesCount );
+
+					pr.appearance = p->_appearance ? appearanceIndices[ p->_appearance ] : NONE;
+					pr.materialFront = p->_materials[ Polygon::FRONT ] ? appearanceIndices[ p->_materials[ Polygon::FRONT ] ] : NONE;
+					pr.materialBack = p->_materials[ Polygon::BACK ] ? appearanceIndices[ p->_materials[ Polygon::BACK ] ] : NONE;
+					pr.texture = p->_texture ? appearanceIndices[ p->_texture ] : NONE;
+
+					// Tesselates the lazy polygons
+					ArrayView<TVec3d> v = p->getVertices();
+					ArrayView<unsigned int> ind = p->getIndices();
+					ArrayView<TVec2f> t = p->getTexCoords();
+
+					pr.vertexOffset = vertices.size();
+					pr.vertexCount = v.size();
+					pr.indexOffset = indices.size();
+					pr.indexCount = ind.size();
+					vertices.insert( vertices.end(), v.begin(), v.end() );
+					indices.insert( indices.end(), ind.begin(), ind.end() );
+
+					pr.texCoordsOffset = NONE;
+					if ( !t.empty() )
+					{
+						pr.texCoordsOffset = texCoords.size();
+						texCoords.insert( texCoords.end(), t.begin(), t.end() );
+					}
+
+					pr.normalsOffset = NONE;
+					if ( !p->hasUniformNormal() )
+					{
+						ArrayView<TVec3f> n = p->getNormals();
+						pr.normalsOffset = normals.size();
+						normals.insert( normals.end(), n.begin(), n.end() );
+					}
+					for ( unsigned int l = 0; l < 3; l++ ) pr.normal[l] = p->_normal[l];
+
+					pr.sourcesFirst = b.sources.size();
+					pr.sourcesCount = p->_sources.size();
+					for ( unsigned int l = 0; l < p->_sources.size(); l++ )
+					{
+						const PolygonRange& src = p->_sources[l];
+						SourceRecord sr = { strings.add( src.id ), src.vertexOffset, src.vertexCount, src.indexOffset, src.indexCount };
+						b.sources.push_back( sr );
+					}
+
+					b.polygons.push_back( pr );
+				}
+
+				b.geometries.push_back( g );
+			}
+
+			b.objects.push_back( r );
+		}
+
+		for ( unsigned int i = 0; i < model._roots.size(); i++ )
+		{
+			std::unordered_map< const CityObject*, uint32_t >::const_iterator c = objectIndices.find( model._roots[i] );
+			if ( c != objectIndices.end() && parents[ c->second ] == NONE && ( b.roots.empty() || c->second > b.roots.back() ) ) b.roots.push_back( c->second );
+		}
+
+		std::vector< char > stringsPayload;
+		strings.write( stringsPayload );
+
+		// Layout the blocks
+		struct Block { uint32_t type; uint32_t count; const void* data; uint64_t size; };
+		Block blocks[ BT_Count + 1 ] =
+		{
+			{ BT_Strings, strings.size(), &stringsPayload[0], stringsPayload.size() },
+			{ BT_Model, 1, &b.model, sizeof( b.model ) },
+#define BLOCK( _type_, _vector_ ) { _type_, (uint32_t)_vector_.size(), _vector_.empty() ? 0 : &_vector_[0], _vector_.size() * sizeof( _vector_[0] ) }
+			BLOCK( BT_Attributes, b.attributes ),
+			BLOCK( BT_Appearances, b.appearances ),
+			BLOCK( BT_Objects, b.objects ),
+			BLOCK( BT_Children, b.children ),
+			BLOCK( BT_Roots, b.roots ),
+			BLOCK( BT_Geometries, b.geometries ),
+			BLOCK( BT_Polygons, b.polygons ),
+			BLOCK( BT_Sources, b.sources ),
+			BLOCK( BT_Vertices, vertices ),
+			BLOCK( BT_TexCoords, texCoords ),
+			BLOCK( BT_Indices, indices ),
+			BLOCK( BT_Normals, normals ),
+#undef BLOCK
+			{ BT_SourceKey, 1, key, sizeof( SourceKey ) }
+		};
+
+		FileHeader header;
+		memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+		header.version = VERSION;
+		header.blocksCount = key ? BT_Count + 1 : BT_Count;
+
+		BlockEntry entries[ BT_Count + 1 ];
+		uint64_t offset = sizeof( header ) + header.blocksCount * sizeof( BlockEntry );
+		for ( unsigned int i = 0; i < header.blocksCount; i++ )
+		{
+			entries[i].type = blocks[i].type;
+			entries[i].count = blocks[i].count;
+			entries[i].offset = offset;
+			entries[i].size = blocks[i].size;
+			offset += ( blocks[i].size + 7 ) & ~(uint64_t)7;
+		}
+
+		// Written aside then renamed, so that the readers never see a partial file and the processes which map
+		// the previous file keep their copy instead of faulting on its truncated pages
+		std::string tmpPath = fileName + "." + toHex( std::chrono::steady_clock::now().time_since_epoch().count() );
+		std::ofstream out( tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( !out )
+		{
+			std::cerr << "CityGML: Unable to create binary model " << fileName << std::endl;
+			return false;
+		}
+
+		static const char padding[8] = { 0 };
+		out.write( (const char*)&header, sizeof( header ) );
+		out.write( (const char*)entries, header.blocksCount * sizeof( BlockEntry ) );
+		for ( unsigned int i = 0; i < header.blocksCount; i++ )
+		{
+			if ( blocks[i].size ) out.write( (const char*)blocks[i].data, blocks[i].size );
+			out.write( padding, ( 8 - blocks[i].size % 8 ) % 8 );
+		}
+
+		out.close();
+		if ( !out || !replaceFile( tmpPath, fileName ) )
+		{
+			std::cerr << "CityGML: Unable to write binary model " << fileName << std::endl;
+			remove( tmpPath.c_str() );
+			return false;
+		}
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	static CityObject* createCityObject( CityObjectsType type, const std::string& id, ObjectArena* arena )
+	{
+		switch ( type )
+		{
+#define CREATE_OBJECT( _t_ ) case COT_ ## _t_: return new ( arena ) _t_( id );
+		CREATE_OBJECT( GenericCityObject );
+		CREATE_OBJECT( Building );
+		CREATE_OBJECT( Room );
+		CREATE_OBJECT( BuildingInstallation );
+		CREATE_OBJECT( BuildingFurniture );
+		CREATE_OBJECT( Door );
+		CREATE_OBJECT( Window );
+		CREATE_OBJECT( CityFurniture );
+		CREATE_OBJECT( Track );
+		CREATE_OBJECT( Road );
+		CREATE_OBJECT( Railway );
+		CREATE_OBJECT( Square );
+		CREATE_OBJECT( PlantCover );
+		CREATE_OBJECT( SolitaryVegetationObject );
+		CREATE_OBJECT( WaterBody );
+		CREATE_OBJECT( TINRelief );
+		CREATE_OBJECT( LandUse );
+		CREATE_OBJECT( Tunnel );
+		CREATE_OBJECT( Bridge );
+		CREATE_OBJECT( BridgeConstructionElement );
+		CREATE_OBJECT( BridgeInstallation );
+		CREATE_OBJECT( BridgePart );
+		CREATE_OBJECT( BuildingPart );
+		CREATE_OBJECT( WallSurface );
+		CREATE_OBJECT( RoofSurface );
+		CREATE_OBJECT( GroundSurface );
+		CREATE_OBJECT( ClosureSurface );
+		CREATE_OBJECT( FloorSurface );
+		CREATE_OBJECT( InteriorWallSurface );
+		CREATE_OBJECT( CeilingSurface );
+#undef CREATE_OBJECT
+		default: return 0;
+		}
+	}
+
+	// Reader of the blocks of a binary model file
+	class BlockReader
+	{
+	public:
+		BlockReader( std::istream& in ) : _in( in ) { memset( _blocks, 0, sizeof( _blocks ) ); }
+
+		// Read & check the header and the blocks directory
+		bool open( void )
+		{
+			_in.seekg( 0, std::ios::end );
+			uint64_t fileSize = _in.tellg();
+			_in.seekg( 0 );
+
+			FileHeader header;
+			if ( !_in.read( (char*)&header, sizeof( header ) ) || !checkHeader( header, fileSize ) ) return false;
+
+			_entries.resize( header.blocksCount );
+			if ( !_in.read( (char*)&_entries[0], header.blocksCount * sizeof( BlockEntry ) ) ) return false;
+
+			return findBlocks( &_entries[0], header.blocksCount, fileSize, _blocks );
+		}
+
+		inline uint32_t getCount( BlockType type ) const { return _blocks[ type ]->count; }
+
+		template< class T > bool read( BlockType type, std::vector< T >& v )
+		{
+			const BlockEntry* e = _blocks[ type ];
+			v.resize( e->size / sizeof( T ) );
+			if ( v.empty() ) return true;
+			_in.seekg( e->offset );
+			return (bool)_in.read( (char*)&v[0], v.size() * sizeof( T ) );
+		}
+
+		// Read the strings table, checking that each string is terminated
+		bool readStrings( std::vector< char >& payload, std::vector< const char* >& strings )
+		{
+			if ( !read( BT_Strings, payload ) ) return false;
+
+			uint64_t count = getCount( BT_Strings );
+			uint64_t header = ( count + 1 ) * sizeof( uint64_t );
+
+			const char* chars = &payload[0] + header;
+			uint64_t charsSize = payload.size() - header;
+			strings.resize( count );
+			for ( uint64_t i = 0; i < count; i++ )
+			{
+				uint64_t begin, end;
+				memcpy( &begin, &payload[ i * sizeof( uint64_t ) ], sizeof( uint64_t ) );
+				memcpy( &end, &payload[ ( i + 1 ) * sizeof( uint64_t ) ], sizeof( uint64_t ) );
+				if ( begin >= end || end > charsSize || chars[ end - 1 ] != 0 ) return false;
+				strings[i] = chars + begin;
+			}
+			return true;
+		}
+
+	private:
+		std::istream& _in;
+		std::vector< BlockEntry > _entries;
+		const BlockEntry* _blocks[ BT_Count ];
+	};
+
+	// Check the references of the records, so that the model can then be built without failing
+	static bool checkModel( const BinaryModel& b, uint32_t stringsCount, uint64_t verticesCount, uint64_t texCoordsCount, const std::vector< unsigned int >& indices, uint64_t normalsCount )
+	{
+		uint32_t appearancesCount = b.appearances.size();
+		uint32_t objectsCount = b.objects.size();
+		uint32_t attributesCount = b.attributes.size();
+
+		if ( b.model.id >= stringsCount || b.model.srsName >= stringsCount || !checkRange( b.model.attributesFirst, b.model.attributesCount, attributesCount ) ) return false;
+
+		for ( unsigned int i = 0; i < b.attributes.size(); i++ )
+			if ( b.attributes[i].name >= stringsCount || b.attributes[i].text >= stringsCount || b.attributes[i].type > AttributeValue::AT_Uri ) return false;
+
+		for ( unsigned int i = 0; i < b.appearances.size(); i++ )
+		{
+			const AppearanceRecord& r = b.appearances[i];
+			if ( r.kind > AK_GeoreferencedTexture || r.id >= stringsCount || r.url >= stringsCount || r.wrapMode > Texture::WM_BORDER ) return false;
+			if ( !checkRange( r.attributesFirst, r.attributesCount, attributesCount ) ) return false;
+		}
+
+		// The geometries & polygons are listed in their owners order, so that each one has a single owner
+		uint32_t geometriesCount = 0;
+		for ( unsigned int i = 0; i < b.objects.size(); i++ )
+		{
+			const ObjectRecord& r = b.objects[i];
+			if ( r.type == 0 || ( r.type & ( r.type - 1 ) ) != 0 || r.type > COT_CeilingSurface || r.id >= stringsCount ) return false;
+			if ( !checkRange( r.attributesFirst, r.attributesCount, attributesCount ) ) return false;
+			if ( r.geometriesFirst != geometriesCount ) return false;
+			geometriesCount += r.geometriesCount;
+		}
+		if ( geometriesCount != b.geometries.size() ) return false;
+
+		if ( !checkHierarchy( b.objects.data(), objectsCount, b.children.data(), b.children.size(), b.roots.data(), b.roots.size() ) ) return false;
+
+		uint32_t polygonsCount = 0;
+		for ( unsigned int i = 0; i < b.geometries.size(); i++ )
+		{
+			const GeometryRecord& r = b.geometries[i];
+			if ( r.id >= stringsCount || r.type > GT_Ceiling || r.object >= objectsCount || !checkRange( r.attributesFirst, r.attributesCount, attributesCount ) ) return false;
+			if ( r.polygonsFirst != polygonsCount ) return false;
+			polygonsCount += r.polygonsCount;
+		}
+		if ( polygonsCount != b.polygons.size() ) return false;
+
+		for ( unsigned int i = 0; i < b.polygons.size(); i++ )
+		{
+			const PolygonRecord& r = b.polygons[i];
+			if ( r.id >= stringsCount || r.geometry >= b.geometries.size() || !checkRange( r.attributesFirst, r.attributesCount, attributesCount ) ) return false;
+
+			const uint32_t apps[] = { r.appearance, r.materialFront, r.materialBack, r.texture };
+			for ( unsigned int k = 0; k < 4; k++ ) if ( apps[k] != NONE && apps[k] >= appearancesCount ) return false;
+			if ( r.materialFront != NONE && b.appearances[ r.materialFront ].kind != AK_Material ) return false;
+			if ( r.materialBack != NONE && b.appearances[ r.materialBack ].kind != AK_Material ) return false;
+			if ( r.texture != NONE && b.appearances[ r.texture ].kind == AK_Material ) return false;
+
+			if ( !checkRange( r.vertexOffset, r.vertexCount, verticesCount ) || !checkRange( r.indexOffset, r.indexCount, indices.size() ) ) return false;
+			for ( unsigned int k = 0; k < r.indexCount; k++ ) if ( indices[ r.indexOffset + k ] >= r.vertexCount ) return false;
+			if ( r.texCoordsOffset != NONE && !checkRange( r.texCoordsOffset, r.vertexCount, texCoordsCount ) ) return false;
+			if ( r.normalsOffset != NONE && !checkRange( r.normalsOffset, r.vertexCount, normalsCount ) ) return false;
+
+			if ( !checkRange( r.sourcesFirst, r.sourcesCount, b.sources.size() ) ) return false;
+			for ( unsigned int k = 0; k < r.sourcesCount; k++ )
+			{
+				// The source ranges are relative to the polygon ones
+				const SourceRecord& s = b.sources[ r.sourcesFirst + k ];
+				if ( s.id >= stringsCount || !checkRange( s.vertexOffset, s.vertexCount, r.vertexCount ) || !checkRange( s.indexOffset, s.indexCount, r.indexCount ) ) return false;
+			}
+		}
+		return true;
+	}
+
+	static void setAttributes( Object* obj, const BinaryModel& b, uint32_t first, uint32_t count, const std::vector< const char* >& strings, StringPool& stringPool )
+	{
+		for ( unsigned int i = first; i < first + count; i++ )
+		{
+			const AttributeRecord& r = b.attributes[i];
+			obj->getAttributes().set( stringPool.intern( strings[ r.name ] ), ModelSerializer::makeValue( strings[ r.text ], r.type, r.value ) );
+		}
+	}
+
+	static Envelope makeEnvelope( const double* e )
+	{
+		return Envelope( TVec3d( e[0], e[1], e[2] ), TVec3d( e[3], e[4], e[5] ) );
+	}
+
+	uint64_t ModelSerializer::getRawValue( const AttributeValue& value )
+	{
+		uint64_t raw;
+		memcpy( &raw, &value._integer, sizeof( raw ) );
+		return raw;
+	}
+
+	AttributeValue ModelSerializer::makeValue( const char* text, uint32_t type, uint64_t raw )
+	{
+		AttributeValue value;
+		value._type = ( type <= AttributeValue::AT_Uri ) ? (AttributeValue::Type)type : AttributeValue::AT_String;
+		value._text = text;
+		memcpy( &value._integer, &raw, sizeof( raw ) );
+		return value;
+	}
+
+	CityModel* ModelSerializer::load( const std::string& fileName, bool quiet )
+	{
+		if ( !isLittleEndianHost() )
+		{
+			if ( !quiet ) std::cerr << "CityGML: Binary models are only supported on little-endian hosts!" << std::endl;
+			return 0;
+		}
+
+		std::ifstream in( fileName.c_str(), std::ios::in | std::ios::binary );
+		if ( !in )
+		{
+			if ( !quiet ) std::cerr << "CityGML: Unable to open binary model " << fileName << std::endl;
+			return 0;
+		}
+
+		BlockReader reader( in );
+		BinaryModel b;
+		std::vector< ModelRecord > modelRecord;
+		std::vector< char > stringsPayload;
+		std::vector< const char* > strings;
+		std::vector< TVec3f > normals;
+
+		// The geometry goes straight to the model shared buffers
+		CityModel* model = new CityModel();
+		GeometryBuffers& buffers = model->_buffers;
+
+		bool ok = reader.open()
+			&& reader.readStrings( stringsPayload, strings )
+			&& reader.read( BT_Model, modelRecord )
+			&& reader.read( BT_Attributes, b.attributes )
+			&& reader.read( BT_Appearances, b.appearances )
+			&& reader.read( BT_Objects, b.objects )
+			&& reader.read( BT_Children, b.children )
+			&& reader.read( BT_Roots, b.roots )
+			&& reader.read( BT_Geometries, b.geometries )
+			&& reader.read( BT_Polygons, b.polygons )
+			&& reader.read( BT_Sources, b.sources )
+			&& reader.read( BT_Vertices, buffers._vertices )
+			&& reader.read( BT_TexCoords, buffers._texCoords )
+			&& reader.read( BT_Indices, buffers._indices )
+			&& reader.read( BT_Normals, normals );
+
+		if ( ok ) b.model = modelRecord[0];
+		ok = ok && checkModel( b, strings.size(), buffers._vertices.size(), buffers._texCoords.size(), buffers._indices, normals.size() );
+
+		if ( !ok )
+		{
+			if ( !quiet ) std::cerr << "CityGML: Invalid binary model " << fileName << std::endl;
+			delete model;
+			return 0;
+		}
+
+		ObjectArena* arena = &model->_arena;
+		StringPool& stringPool = model->_stringPool;
+
+		model->_id = strings[ b.model.id ];
+		model->_srsName = strings[ b.model.srsName ];
+		model->_envelope = makeEnvelope( b.model.envelope );
+		model->_translation = TVec3d( b.model.translation[0], b.model.translation[1], b.model.translation[2] );
+		setAttributes( model, b, b.model.attributesFirst, b.model.attributesCount, strings, stringPool );
+
+		std::vector< Appearance* > appearances( b.appearances.size() );
+		std::vector< Material* > materials( b.appearances.size(), 0 );
+		std::vector< Texture* > textures( b.appearances.size(), 0 );
+		for ( unsigned int i = 0; i < b.appearances.size(); i++ )
+		{
+			const AppearanceRecord& r = b.appearances[i];
+			if ( r.kind == AK_Material )
+			{
+				Material* mat = new ( arena ) Material( strings[ r.id ] );
+				mat->_diffuse = TVec3f( r.diffuse[0], r.diffuse[1], r.diffuse[2] );
+				mat->_emissive = TVec3f( r.emissive[0], r.emissive[1], r.emissive[2] );
+				mat->_specular = TVec3f( r.specular[0], r.specular[1], r.specular[2] );
+				mat->_ambientIntensity = r.ambientIntensity;
+				mat->_shininess = r.shininess;
+				mat->_transparency = r.transparency;
+				model->_appearanceManager.addAppearance( mat );
+				appearances[i] = materials[i] = mat;
+			}
+			else
+			{
+				GeoreferencedTexture* geoTex = ( r.kind == AK_GeoreferencedTexture ) ? new ( arena ) GeoreferencedTexture( strings[ r.id ] ) : 0;
+				Texture* tex = geoTex ? geoTex : new ( arena ) Texture( strings[ r.id ] );
+				if ( geoTex ) geoTex->_preferWorldFile = r.preferWorldFile != 0;
+				tex->_url = stringPool.intern( strings[ r.url ] );
+				tex->_repeat = r.repeat != 0;
+				tex->_wrapMode = (Texture::WrapMode)r.wrapMode;
+				tex->_borderColor = TVec4f( r.borderColor[0], r.borderColor[1], r.borderColor[2], r.borderColor[3] );
+				model->_appearanceManager.addAppearance( tex );
+				appearances[i] = textures[i] = tex;
+			}
+			appearances[i]->_isFront = r.isFront != 0;
+			setAttributes( appearances[i], b, r.attributesFirst, r.attributesCount, strings, stringPool );
+		}
+
+		std::vector< CityObject* > objects( b.objects.size() );
+		for ( unsigned int i = 0; i < b.objects.size(); i++ )
+		{
+			const ObjectRecord& r = b.objects[i];
+			objects[i] = createCityObject( (CityObjectsType)r.type, strings[ r.id ], arena );
+			objects[i]->_envelope = makeEnvelope( r.envelope );
+			setAttributes( objects[i], b, r.attributesFirst, r.attributesCount, strings, stringPool );
+			model->addCityObject( objects[i] );
+		}
+
+		for ( unsigned int i = 0; i < b.objects.size(); i++ )
+		{
+			const ObjectRecord& r = b.objects[i];
+			objects[i]->_children.reserve( r.childrenCount );
+			for ( unsigned int j = r.childrenFirst; j < r.childrenFirst + r.childrenCount; j++ ) objects[i]->_children.push_back( objects[ b.children[j] ] );
+			objects[i]->_geometries.reserve( r.geometriesCount );
+		}
+
+		for ( unsigned int i = 0; i < b.roots.size(); i++ ) model->addCityObjectAsRoot( objects[ b.roots[i] ] );
+
+		for ( unsigned int i = 0; i < b.geometries.size(); i++ )
+		{
+			const GeometryRecord& r = b.geometries[i];
+			Geometry* geom = new ( arena ) Geometry( strings[ r.id ], (GeometryType)r.type, r.lod );
+			setAttributes( geom, b, r.attributesFirst, r.attributesCount, strings, stringPool );
+			objects[ r.object ]->_geometries.push_back( geom );
+
+			geom->_polygons.reserve( r.polygonsCount );
+			for ( unsigned int j = r.polygonsFirst; j < r.polygonsFirst + r.polygonsCount; j++ )
+			{
+				const PolygonRecord& pr = b.polygons[j];
+				Polygon* p = new ( arena ) Polygon( strings[ pr.id ] );
+				setAttributes( p, b, pr.attributesFirst, pr.attributesCount, strings, stringPool );
+
+				p->_geometry = geom;
+				p->_appearance = ( pr.appearance != NONE ) ? appearances[ pr.appearance ] : 0;
+				p->_materials[ Polygon::FRONT ] = ( pr.materialFront != NONE ) ? materials[ pr.materialFront ] : 0;
+				p->_materials[ Polygon::BACK ] = ( pr.materialBack != NONE ) ? materials[ pr.materialBack ] : 0;
+				p->_texture = ( pr.texture != NONE ) ? textures[ pr.texture ] : 0;
+
+				p->setBuffers( buffers, pr.vertexOffset, pr.vertexCount, pr.indexOffset, pr.indexCount );
+				if ( pr.texCoordsOffset != NONE ) p->setTexCoordsBuffer( buffers, pr.texCoordsOffset );
+
+				p->_normal = TVec3f( pr.normal[0], pr.normal[1], pr.normal[2] );
+				if ( pr.normalsOffset != NONE ) p->_packedNormals = arena->copy( &normals[ pr.normalsOffset ], pr.vertexCount );
+
+				p->_sources.reserve( pr.sourcesCount );
+				for ( unsigned int k = pr.sourcesFirst; k < pr.sourcesFirst + pr.sourcesCount; k++ )
+				{
+					const SourceRecord& s = b.sources[k];
+					p->_sources.push_back( PolygonRange( strings[ s.id ], s.vertexOffset, s.vertexCount, s.indexOffset, s.indexCount ) );
+				}
+
+				geom->_polygons.push_back( p );
+			}
+		}
+
+		return model;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// 64 bits FNV-1a, unlike std::hash it is stable across platforms & runs
+	static uint64_t hashBytes( const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL )
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for ( size_t i = 0; i < size; i++ ) hash = ( hash ^ bytes[i] ) * 0x100000001b3ULL;
+		return hash;
+	}
+
+	static std::string getAbsolutePath( const std::string& fileName )
+	{
+#ifdef WIN32
+		char path[ _MAX_PATH ];
+		return _fullpath( path, fileName.c_str(), _MAX_PATH ) ? path : fileName;
+#else
+		char* path = realpath( fileName.c_str(), 0 );
+		if ( !path ) return fileName;
+		std::string absolutePath( path );
+		free( path );
+		return absolutePath;
+#endif
+	}
+
+	// Check that a directory exists and is writable, creating it (but not its parents) when missing
+	static bool isWritableDirectory( const std::string& dir )
+	{
+		struct stat st;
+#ifdef WIN32
+		if ( stat( dir.c_str(), &st ) != 0 ) _mkdir( dir.c_str() );
+		return stat( dir.c_str(), &st ) == 0 && ( st.st_mode & S_IFDIR ) && _access( dir.c_str(), 2 ) == 0;
+#else
+		if ( stat( dir.c_str(), &st ) != 0 ) mkdir( dir.c_str(), 0777 );
+		return stat( dir.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) && access( dir.c_str(), W_OK ) == 0;
+#endif
+	}
+
+	ModelCache::ModelCache( const std::string& fileName, const ParserParams& params ) : _spatialIndex( params.spatialIndex )
+	{
+		memset( &_key, 0, sizeof( _key ) );
+
+		// The caching is quietly disabled when the directory is not usable, rather than failing each save
+		if ( params.cacheDir.empty() || !isLittleEndianHost() || !isWritableDirectory( params.cacheDir ) ) return;
+
+		struct stat st;
+		if ( stat( fileName.c_str(), &st ) != 0 ) return;
+		_key.size = st.st_size;
+		_key.mtime = st.st_mtime;
+
+		// Sample the head, middle & tail of the file, which catches most edits keeping the size within the same second
+		const uint64_t sampleSize = 16384;
+		std::ifstream in( fileName.c_str(), std::ios::in | std::ios::binary );
+		if ( !in ) return;
+		std::vector< char > sample( sampleSize );
+		const uint64_t positions[] = { 0, _key.size / 2, ( _key.size > sampleSize ) ? _key.size - sampleSize : 0 };
+		_key.contentHash = hashBytes( 0, 0 );
+		for ( unsigned int i = 0; i < 3; i++ )
+		{
+			in.clear();
+			in.seekg( positions[i] );
+			in.read( &sample[0], sampleSize );
+			_key.contentHash = hashBytes( &sample[0], in.gcount(), _key.contentHash );
+		}
+
+		// The parameters which change the resulting model
+		std::ostringstream p;
+		p.precision( 17 );
+		p << VERSION << '|' << params.objectsMask << '|' << params.minLOD << '|' << params.maxLOD << '|' << params.optimize << '|' << params.mergeChildren 
+			<< '|' << params.pruneEmptyObjects << '|' << params.tesselate << '|' << params.destSRS << '|' << params.vertexTolerance;
+		_key.paramsHash = hashBytes( p.str().data(), p.str().size() );
+
+		// One sidecar per file & parameters, named after the file for readability
+		std::string absolutePath = getAbsolutePath( fileName );
+		std::string::size_type slash = absolutePath.find_last_of( "/\\" );
+		std::string name = ( slash != std::string::npos ) ? absolutePath.substr( slash + 1 ) : absolutePath;
+		uint64_t pathHash = hashBytes( absolutePath.data(), absolutePath.size(), _key.paramsHash );
+
+		_path = params.cacheDir;
+		if ( _path[ _path.size() - 1 ] != '/' && _path[ _path.size() - 1 ] != '\\' ) _path += '/';
+		_path += name + "." + toHex( pathHash ) + ".cgb";
+	}
+
+	CityModel* ModelCache::load( void ) const
+	{
+		if ( _path.empty() ) return 0;
+
+		// Read the key of the sidecar, if any
+		std::ifstream in( _path.c_str(), std::ios::in | std::ios::binary );
+		if ( !in ) return 0;
+		in.seekg( 0, std::ios::end );
+		uint64_t fileSize = in.tellg();
+		in.seekg( 0 );
+
+		FileHeader header;
+		if ( !in.read( (char*)&header, sizeof( header ) ) || !checkHeader( header, fileSize ) ) return 0;
+		std::vector< BlockEntry > entries( header.blocksCount );
+		if ( !in.read( (char*)&entries[0], entries.size() * sizeof( BlockEntry ) ) ) return 0;
+
+		SourceKey key;
+		bool found = false;
+		for ( unsigned int i = 0; i < entries.size() && !found; i++ )
+		{
+			const BlockEntry& e = entries[i];
+			if ( e.type != BT_SourceKey || e.size != sizeof( key ) || !checkRange( e.offset, e.size, fileSize ) ) continue;
+			in.seekg( e.offset );
+			found = (bool)in.read( (char*)&key, sizeof( key ) );
+		}
+		in.close();
+
+		if ( !found || memcmp( &key, &_key, sizeof( key ) ) != 0 ) return 0;
+
+		// A damaged sidecar is quietly parsed again, then replaced
+		CityModel* model = ModelSerializer::load( _path, true );
+		if ( model && _spatialIndex ) model->_spatialIndex = new SpatialIndex( *model );
+		return model;
+	}
+
+	void ModelCache::save( const CityModel& model ) const
+	{
+		if ( _path.empty() ) return;
+
+		// Written aside then renamed by the serializer, so that concurrent loads never see a partial sidecar
+		ModelSerializer::save( model, _path, &_key );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	bool save_binary( const CityModel& model, const std::string& fileName )
+	{
+		return ModelSerializer::save( model, fileName );
+	}
+
+	CityModel* load_binary( const std::string& fileName )
+	{
+		return ModelSerializer::load( fileName );
+	}
+}
@@ -0,0 +1,222 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#ifndef __BINARYFORMAT_H__
+#define __BINARYFORMAT_H__
+
+#include <stdint.h>
+#include <string>
+
+// Layout of the binary model files (see citygml::save_binary).
+// A file is a header, a directory of blocks, then the blocks payloads, each one 8 bytes aligned.
+// Everything is little-endian. The records only hold 32 & 64 bits fields and refer to each other,
+// and to the strings table, by index, so that the payloads can be read in bulk or used in place.
+
+namespace citygml
+{
+	class CityModel;
+	class MappedCityModel;
+	class ParserParams;
+	class AttributeValue;
+
+	namespace binary
+	{
+		const char MAGIC[8] = { 'C', 'I', 'T', 'Y', 'G', 'M', 'L', 'B' };
+		const uint32_t VERSION = 3;
+
+		// Null reference
+		const uint32_t NONE = 0xFFFFFFFF;
+
+		enum BlockType
+		{
+			BT_Strings = 0,		// uint64_t offsets[count + 1] from the end of the offsets, then the null terminated strings
+			BT_Model,			// one ModelRecord
+			BT_Attributes,		// AttributeRecord, contiguous for each object
+			BT_Appearances,		// AppearanceRecord
+			BT_Objects,			// ObjectRecord, in pre-order: each object before its children
+			BT_Children,		// uint32_t object indices, the children lists of the objects, each one increasing
+			BT_Roots,			// uint32_t object indices, increasing
+			BT_Geometries,		// GeometryRecord
+			BT_Polygons,		// PolygonRecord
+			BT_Sources,			// SourceRecord, the source polygons of the merged polygons
+			BT_Vertices,		// double[3]
+			BT_TexCoords,		// float[2], one per vertex of the textured polygons
+			BT_Indices,			// uint32_t, relative to the polygon vertices
+			BT_Normals,			// float[3], one per vertex of the polygons without uniform normal
+			BT_Count
+		};
+
+		// Optional blocks, skipped by the readers which do not know them
+		const uint32_t BT_SourceKey = 0x100;	// one SourceKey, for the sidecar cache files (see ModelCache)
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t blocksCount;
+		};
+
+		struct BlockEntry
+		{
+			uint32_t type;
+			uint32_t count;		// number of elements
+			uint64_t offset;	// from the beginning of the file
+			uint64_t size;		// in bytes, padding excluded
+		};
+
+		struct ModelRecord
+		{
+			uint32_t id, srsName;
+			uint32_t attributesFirst, attributesCount;
+			double envelope[6];
+			double translation[3];
+		};
+
+		struct AttributeRecord
+		{
+			uint32_t name, text;
+			uint32_t type, reserved;
+			uint64_t value;		// the parsed double (bitwise) or integer value of the typed attributes
+		};
+
+		enum AppearanceKind
+		{
+			AK_Material = 0,
+			AK_Texture,
+			AK_GeoreferencedTexture
+		};
+
+		struct AppearanceRecord
+		{
+			uint32_t kind, id, isFront;
+			uint32_t attributesFirst, attributesCount;
+			uint32_t url, repeat, wrapMode, preferWorldFile;	// textures
+			float borderColor[4];
+			float diffuse[3], emissive[3], specular[3];			// materials
+			float ambientIntensity, shininess, transparency;
+			uint32_t reserved;
+		};
+
+		struct ObjectRecord
+		{
+			uint32_t type, id;
+			uint32_t attributesFirst, attributesCount;
+			uint32_t geometriesFirst, geometriesCount;
+			uint32_t childrenFirst, childrenCount;		// range of the children block
+			uint32_t parent, reserved;					// NONE for the objects without parent
+			double envelope[6];
+		};
+
+		struct GeometryRecord
+		{
+			uint32_t id, type, lod, object;
+			uint32_t attributesFirst, attributesCount;
+			uint32_t polygonsFirst, polygonsCount;
+		};
+
+		struct PolygonRecord
+		{
+			uint32_t id, geometry;
+			uint32_t attributesFirst, attributesCount;
+			uint32_t appearance, materialFront, materialBack, texture;		// appearance indices
+			uint32_t vertexOffset, vertexCount, indexOffset, indexCount;
+			uint32_t texCoordsOffset;	// NONE when the polygon has no texture coordinates
+			uint32_t normalsOffset;		// NONE when the polygon normal is uniform
+			uint32_t sourcesFirst, sourcesCount;
+			float normal[3];
+		};
+
+		struct SourceRecord
+		{
+			uint32_t id;
+			uint32_t vertexOffset, vertexCount, indexOffset, indexCount;
+		};
+
+		// Identity of the CityGML file & parser parameters a cached model was built from
+		struct SourceKey
+		{
+			uint64_t size;
+			int64_t mtime;
+			uint64_t contentHash;	// of samples of the head, middle & tail of the file
+			uint64_t paramsHash;
+		};
+
+		// Size of a record, for the validation of the blocks sizes
+		uint64_t getRecordSize( BlockType type );
+
+		// Check the magic & version of a file, and that its blocks directory fits in it
+		bool checkHeader( const FileHeader& header, uint64_t fileSize );
+
+		// Check the blocks directory and find the entry of each block type, all being required
+		bool findBlocks( const BlockEntry* entries, uint32_t count, uint64_t fileSize, const BlockEntry* blocks[ BT_Count ] );
+
+		// Check that the [first, first + count) range lies in [0, size)
+		inline bool checkRange( uint64_t first, uint64_t count, uint64_t size ) { return first <= size && count <= size - first; }
+
+		// Check the i-th object of a children list of parent, or of the roots list with a NONE parent. The object must refer back to
+		// its parent, come after it & after the previous object of the list: each object is then reached at most once & never from
+		// its descendants, so the objects form a forest without having to walk it.
+		inline bool checkListed( const ObjectRecord* objects, uint32_t objectsCount, uint32_t parent, const uint32_t* list, uint32_t i )
+		{
+			uint32_t object = list[i];
+			return object < objectsCount && objects[ object ].parent == parent && ( parent == NONE || object > parent ) && ( i == 0 || object > list[ i - 1 ] );
+		}
+
+		// Check all the children & roots lists with checkListed
+		bool checkHierarchy( const ObjectRecord* objects, uint32_t objectsCount, const uint32_t* children, uint64_t childrenCount, const uint32_t* roots, uint64_t rootsCount );
+
+		inline bool isLittleEndianHost( void ) { const uint16_t one = 1; return *(const unsigned char*)&one == 1; }
+	}
+
+	// Writer & reader of the binary model files, friend of the model classes
+	class ModelSerializer
+	{
+	public:
+		static bool save( const CityModel&, const std::string& fileName, const binary::SourceKey* key = 0 );
+
+		// Quiet loads print no error, for the callers which fall back to parsing
+		static CityModel* load( const std::string& fileName, bool quiet = false );
+
+		static MappedCityModel* map( const std::string& fileName );
+
+		// Raw access to the typed value of the attributes
+		static uint64_t getRawValue( const AttributeValue& );
+		static AttributeValue makeValue( const char* text, uint32_t type, uint64_t raw );
+	};
+
+	// Sidecar binary file caching the model parsed from a CityGML file (see ParserParams::cacheDir)
+	class ModelCache
+	{
+	public:
+		ModelCache( const std::string& fileName, const ParserParams& );
+
+		// Path of the sidecar, empty when the caching is disabled
+		inline const std::string& getPath( void ) const { return _path; }
+
+		// Load the sidecar if it was built from the same file content & parameters, null otherwise
+		CityModel* load( void ) const;
+
+		// Write the sidecar of a freshly parsed model
+		void save( const CityModel& ) const;
+
+	private:
+		std::string _path;	// empty when the cache is disabled, its directory is not writable or the file cannot be read
+		binary::SourceKey _key;
+		bool _spatialIndex;
+	};
+}
+
+#endif
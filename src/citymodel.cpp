@@ -1,654 +1,1275 @@
-/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
- *
- * Contributors:
- *  - Manuel Garnier, BRGM - better normal computation
- *
- * This file is part of libcitygml library
- * http://code.google.com/p/libcitygml
- *
- * libcitygml is free software: you can redistribute it and/or modify
- * it under the terms of the GNU Lesser General Public License as published by
- * the Free Software Foundation, either version 2.1 of the License, or
- * (at your option) any later version.
- *
- * libcitygml is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU Lesser General Public License for more details.
-*/
-
-#include "tesselator.h"
-#include "citygml.h"
-#include "utils.h"
-#include <string.h>
-#include <limits>
-#include <iterator>
-#include <set>
-
-#ifndef min
-#	define min( a, b ) ( ( ( a ) < ( b ) ) ? ( a ) : ( b ) )
-#endif
-
-///////////////////////////////////////////////////////////////////////////////
-
-namespace citygml
-{
-	std::ostream& operator<<( std::ostream& os, const Envelope& e ) 
-	{
-		return os << e.getLowerBound() << " " << e.getUpperBound();
-	}
-
-	std::ostream& operator<<( std::ostream& os, const Object& o ) 
-	{ 
-		return os << o.getId();
-	}
-
-	std::ostream& operator<<( std::ostream& os, const citygml::Geometry& s )
-	{
-		unsigned int count = 0;
-		for ( unsigned int i = 0; i < s.size(); i++ )
-		{
-			os << *s[i];
-			count += s[i]->getVertices().size();
-		}
-
-		os << "  @ " << s._polygons.size() << " polys [" << count << " vertices]" << std::endl;
-
-		return os;
-	}
-
-	std::ostream& operator<<( std::ostream& os, const CityObject& o ) 
-	{
-		os << o.getType() << ": " << o.getId() << std::endl;
-		os << "  Envelope: " << o.getEnvelope() << std::endl;
-
-		AttributesMap::const_iterator it = o._attributes.begin();
-		while ( it != o._attributes.end() )
-		{
-			os << "  + " << it->first << ": " << it->second << std::endl;
-			it++;
-		}
-
-		std::vector< Geometry* >::const_iterator itp = o._geometries.begin();
-		for ( ; itp != o._geometries.end(); itp++ ) 
-			os << **itp;
-
-		os << "  * " << o._geometries.size() << " geometries." << std::endl;
-
-		return os;
-	}
-
-	std::ostream& operator<<( std::ostream& out, const CityModel& model ) 
-	{
-		const CityObjectsMap& cityObjectsMap = model.getCityObjectsMap();
-
-		CityObjectsMap::const_iterator it = cityObjectsMap.begin();
-
-		for ( ; it != cityObjectsMap.end(); ++it )
-
-			for ( unsigned int i = 0; i < it->second.size(); i++ ) out << *(it->second[i]);
-
-		out << model.size() << " city objects." << std::endl;	
-
-		return out;
-	}
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	TVec3d LinearRing::computeNormal( void ) const
-	{
-		unsigned int len = size();
-		if ( len < 3 ) return TVec3d();
-
-		// Tampieri, F. 1992. Newell's method for computing the plane equation of a polygon. In Graphics Gems III, pp.231-232. 
-		TVec3d n( 0., 0., 0. );
-		for ( unsigned int i = 0; i < len; i++ )
-		{
-			const TVec3d& current = _vertices[i];
-			const TVec3d& next = _vertices[ ( i + 1 ) % len];
-
-			n.x += ( current.y - next.y ) * ( current.z + next.z );
-			n.y += ( current.z - next.z ) * ( current.x + next.x );
-			n.z += ( current.x - next.x ) * ( current.y + next.y );
-		}
-		return n.normal();
-	}
-
-	void LinearRing::finish( TexCoords* texCoords )
-	{
-		// Remove duplicated vertex
-		unsigned int len = _vertices.size();
-		if ( len < 2 ) return;
-
-		for ( unsigned int i = 0; i < len; i++ )
-		{
-			if ( ( _vertices[i] - _vertices[ ( i + 1 ) % len ] ).sqrLength() <= std::numeric_limits<float>::epsilon() )
-			{
-				_vertices.erase( _vertices.begin() + i );
-				if ( texCoords && texCoords->size() > i) texCoords->erase( texCoords->begin() + i );
-				finish( texCoords );
-				return;
-			}
-		}
-	}
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	AppearanceManager::AppearanceManager( void ) : _lastId( "" ), _lastCoords( 0 ) 
-	{
-		_tesselator = new ::Tesselator();
-	}
-
-	AppearanceManager::~AppearanceManager( void ) 
-	{
-		for ( unsigned int i = 0; i < _appearances.size(); i++ ) delete _appearances[i];
-
-		std::set<TexCoords*> texCoords;
-		for ( std::map<std::string, TexCoords*>::iterator it = _texCoordsMap.begin(); it != _texCoordsMap.end(); ++it )
-		{
-			if ( it->second && texCoords.find(it->second) == texCoords.end() ) 
-			{
-				texCoords.insert(it->second);
-				delete it->second;
-			}
-		}
-
-		for ( std::vector<TexCoords*>::iterator it = _obsoleteTexCoords.begin(); it != _obsoleteTexCoords.end(); it++ )
-			if ( texCoords.find(*it) == texCoords.end() )
-				delete *it;
-
-		delete _tesselator;
-	}
-
-	void AppearanceManager::refresh( void )
-	{
-		_lastCoords = 0;
-		_lastId = "";
-	}
-
-	template <typename AppType>
-	AppType AppearanceManager::getAppearance( const std::string& nodeid, ForSide side /*= FS_ANY*/ ) const
-	{
-		std::map< std::string, std::vector< Appearance* > >::const_iterator map_iterator = _appearancesMap.find( nodeid );
-		if ( map_iterator == _appearancesMap.end() ) return 0;
-
-		std::vector< Appearance* >::const_iterator vector_iterator = ( map_iterator->second ).begin();
-		for( ; vector_iterator != ( map_iterator->second ).end(); ++vector_iterator ) {
-			if ( AppType appType = dynamic_cast< AppType >( *vector_iterator ) ) {
-				if ( side == FS_ANY || 
-					( side == FS_FRONT && appType->getIsFront() ) ||
-					( side == FS_BACK && !appType->getIsFront() ) )
-				{
-					return appType;
-				}
-			}
-		}
-
-		return 0;
-	}
-
-	void AppearanceManager::addAppearance( Appearance* app ) 
-	{ 
-		if ( app ) _appearances.push_back( app ); 
-	}
-
-	void AppearanceManager::assignNode( const std::string& nodeid )
-	{ 
-		_lastId = nodeid; 
-
-		if ( !getAppearance< Appearance * >( nodeid ) )
-			_appearancesMap[ nodeid ] = std::vector< Appearance* >(0);
-
-		Appearance* currentAppearance = _appearances[ _appearances.size() - 1 ];
-		ForSide side = currentAppearance->getIsFront() ? FS_FRONT : FS_BACK;
-		if ( dynamic_cast< Texture* >( currentAppearance ) && !getAppearance< Texture* >( nodeid, side ) ||
-			 dynamic_cast< Material* >( currentAppearance ) && !getAppearance< Material* >( nodeid, side ) )
-		{
-			(_appearancesMap[ nodeid ]).push_back( currentAppearance );
-			if ( _lastCoords ) { assignTexCoords( _lastCoords ); _lastId = ""; }
-		}
-	}
-
-	bool AppearanceManager::assignTexCoords( TexCoords* tex ) 
-	{ 
-		_lastCoords = tex;
-        if ( _lastId == "" )
-		{
-            _obsoleteTexCoords.push_back( tex );   
-            return false;
-        }
-		_texCoordsMap[ _lastId ] = tex; 
-		_lastCoords = 0;
-		_lastId = "";
-		return true;
-	}
-
-    void AppearanceManager::finish(void)
-    {
-        std::set<TexCoords*> useLessTexCoords;
-
-		for ( std::map<std::string, TexCoords*>::iterator it = _texCoordsMap.begin(); it != _texCoordsMap.end(); ++it )
-		{
-			if ( it->second && useLessTexCoords.find( it->second ) == useLessTexCoords.end() )
-			{
-				useLessTexCoords.insert( it->second );
-				delete it->second;
-			}
-		}
-
-        for ( std::vector<TexCoords*>::iterator it = _obsoleteTexCoords.begin(); it != _obsoleteTexCoords.end(); it++ )
-            if ( useLessTexCoords.find( *it ) == useLessTexCoords.end() )
-                delete *it;
-
-		_appearancesMap.clear();
-        _texCoordsMap.clear();
-        _obsoleteTexCoords.clear();
-    }
-		
-	///////////////////////////////////////////////////////////////////////////////
-
-	Polygon::~Polygon( void ) 
-	{ 
-		delete _exteriorRing;
-		std::vector< LinearRing* >::const_iterator it = _interiorRings.begin();
-		for ( ; it != _interiorRings.end(); ++it ) delete *it;
-	}
-
-	TVec3d Polygon::computeNormal( void ) 
-	{
-		if ( !_exteriorRing ) return TVec3d();
-
-		TVec3d normal = _exteriorRing->computeNormal();
-
-		return _negNormal ? -normal : normal;
-	}
-
-	void Polygon::tesselate( AppearanceManager &appearanceManager, const TVec3d& normal )
-	{
-		_indices.clear();
-
-		if ( !_exteriorRing || _exteriorRing->size() < 3 )
-		{ 
-			mergeRings( appearanceManager );
-			return;
-		}
-
-		TexCoords texCoords;
-		bool t = appearanceManager.getTexCoords( _exteriorRing->getId(), texCoords );
-		_exteriorRing->finish( t ? &texCoords : &_texCoords );
-		if ( t ) std::copy( texCoords.begin(), texCoords.end(), std::back_inserter( _texCoords ) );
-
-		for ( unsigned int i = 0; i < _interiorRings.size(); i++ ) {
-			TexCoords texCoords;
-			bool t = appearanceManager.getTexCoords( _interiorRings[i]->getId(), texCoords );
-			_interiorRings[i]->finish( t ? &texCoords : &_texCoords );
-			if ( t ) std::copy( texCoords.begin(), texCoords.end(), std::back_inserter( _texCoords ) );
-		}
-
-		// Compute the total number of vertices
-		unsigned int vsize = _exteriorRing->size();
-		for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
-			vsize += _interiorRings[i]->size();
-
-		Tesselator* tess = appearanceManager.getTesselator();
-		tess->init( vsize, normal );
-
-		tess->addContour( _exteriorRing->getVertices(), texCoords );
-
-		for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
-			tess->addContour( _interiorRings[i]->getVertices(), texCoords ); 
-
-		tess->compute();
-		_vertices.reserve( tess->getVertices().size() );
-		std::copy( tess->getVertices().begin(), tess->getVertices().end(), std::back_inserter( _vertices ) );
-
-		unsigned int indicesSize = tess->getIndices().size();
-		if ( indicesSize > 0 ) 
-		{
-			_indices.resize( indicesSize );
-			memcpy( &_indices[0], &tess->getIndices()[0], indicesSize * sizeof(unsigned int) );
-		}
-		clearRings();
-	}
-
-	void Polygon::mergeRings( AppearanceManager &appearanceManager )
-	{
-		_vertices.reserve( _vertices.size() + _exteriorRing->size() );
-		TexCoords texCoords;
-		bool t = appearanceManager.getTexCoords( _exteriorRing->getId(), texCoords );
-		_exteriorRing->finish( t ? &texCoords : &_texCoords ); 
-		if ( t ) std::copy( texCoords.begin(), texCoords.end(), std::back_inserter( _texCoords ) );
-
-		std::copy( _exteriorRing->getVertices().begin(), _exteriorRing->getVertices().end(), std::back_inserter( _vertices ) );
-
-		for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
-		{
-			TexCoords texCoords;
-			bool t = appearanceManager.getTexCoords( _interiorRings[i]->getId(), texCoords );
-			_interiorRings[i]->finish( t ? &texCoords : &_texCoords );
-			if ( t ) std::copy( texCoords.begin(), texCoords.end(), std::back_inserter( _texCoords ) );
-
-			_vertices.reserve( _vertices.size() + _interiorRings[i]->size() );
-
-			std::copy( _interiorRings[i]->getVertices().begin(), _interiorRings[i]->getVertices().end(), std::back_inserter( _vertices ) );
-		}
-		clearRings();
-		_indices.clear();
-
-		if ( _vertices.size() < 3 ) return;
-
-		// Create triangles' indices
-		int indicesSize = 3 * ( _vertices.size() - 2 );
-		if ( indicesSize < 3 ) return;
-		_indices.resize( indicesSize );
-		for ( int i = 0, p = 0; p < indicesSize - 2; i++, p += 3 )
-			for ( unsigned int j = 0; j < 3; j++ )
-				_indices[ p + j ] = i + j;
-	}
-
-	void Polygon::clearRings( void )
-	{
-		delete _exteriorRing;
-		_exteriorRing = 0;
-		for ( unsigned int i = 0; i < _interiorRings.size(); i++ ) delete _interiorRings[i]; 
-		_interiorRings.clear();
-	}
-
-	// Merge polygon p into the current polygon
-	bool Polygon::merge( Polygon* p )
-	{
-		if ( !p ) return false;
-
-		if ( p->getAppearance() != getAppearance() ) return false;
-
-		if ( p->getVertices().size() == 0 ) return true;
-
-		// merge vertices
-		unsigned int oldVSize = _vertices.size();
-		unsigned int pVSize = p->_vertices.size();
-		_vertices.resize( oldVSize + pVSize );
-		for ( unsigned int i = 0; i < pVSize; i++ )
-			_vertices[ oldVSize + i ] = p->_vertices[i];
-		p->_vertices.clear();
-		
-		// merge indices
-		{
-			unsigned int oldSize = _indices.size();
-			unsigned int pSize = p->_indices.size();
-			_indices.resize( oldSize + pSize );
-			for ( unsigned int i = 0; i < pSize; i++ )
-				_indices[ oldSize + i ] = oldVSize + p->_indices[i];
-			p->_indices.clear();
-		}
-
-		// merge normals
-		{
-			unsigned int oldSize = _normals.size();
-			unsigned int pSize = p->_normals.size();
-			_normals.resize( oldSize + pSize );
-			for ( unsigned int i = 0; i < pSize; i++ )
-				_normals[ oldSize + i ] = p->_normals[i];
-			p->_normals.clear();
-		}
-
-		// merge texcoords
-		{
-			unsigned int oldSize = min( _texCoords.size(), oldVSize );
-			unsigned int pSize = min( p->_texCoords.size(), pVSize );
-			_texCoords.resize( oldSize + pSize );
-			for ( unsigned int i = 0; i < pSize; i++ )
-				_texCoords[ oldSize + i ] = p->_texCoords[i];
-			p->_texCoords.clear();
-		}
-
-		// merge ids
-		_id += "+" + p->_id;
-
-		return true;
-	}
-
-	void Polygon::finish( AppearanceManager& appearanceManager, bool doTesselate ) 
-	{
-		TVec3d normal = computeNormal();
-		if ( doTesselate ) tesselate( appearanceManager, normal );	else mergeRings( appearanceManager );
-
-		// Create the normal per point field
-		_normals.resize( _vertices.size() );
-		for ( unsigned int i = 0; i < _vertices.size(); i++ )
-			_normals[i] = TVec3f( (float)normal.x, (float)normal.y, (float)normal.z );
-	}
-
-	void Polygon::finish( AppearanceManager& appearanceManager, Appearance* defAppearance, bool doTesselate )
-	{	
-		if ( !appearanceManager.getTexCoords( getId(), _texCoords ) ) 
-			appearanceManager.getTexCoords( _geometry->getId(), _texCoords );
-				
-		finish( appearanceManager, doTesselate );
-		
-		_texCoords.resize( _vertices.size() );
-		
-		const std::string id = getId();
-		_appearance = appearanceManager.getAppearance( id );
-		if ( !_appearance ) _appearance = defAppearance;
-
-		_materials[ FRONT ] = appearanceManager.getMaterialFront( id );
-		_materials[ BACK ] = appearanceManager.getMaterialBack( id );
- 		if ( !_materials[ FRONT ]  && !_materials[ BACK ])
- 			_materials[ FRONT ] = dynamic_cast< Material * >( defAppearance );
-
-		_texture = appearanceManager.getTexture( id );
-		if ( !_texture ) _texture = dynamic_cast< Texture * >( defAppearance );
-	}
-
-	void Polygon::addRing( LinearRing* ring ) 
-	{
-		if ( ring->isExterior() ) _exteriorRing = ring;
-		else _interiorRings.push_back( ring );
-	}
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	Geometry::~Geometry() 
-	{ 
-		std::vector< Polygon* >::const_iterator it = _polygons.begin();
-		for ( ; it != _polygons.end(); ++it ) delete *it;
-	}
-
-	void Geometry::addPolygon( Polygon* p ) 
-	{ 
-		p->_geometry = this;
-		_polygons.push_back( p ); 
-	}
-
-	void Geometry::finish( AppearanceManager& appearanceManager, Appearance* defAppearance,  const ParserParams& params )
-	{
-		Appearance* myappearance = appearanceManager.getAppearance( getId() );
-		std::vector< Polygon* >::const_iterator it = _polygons.begin();
-		for ( ; it != _polygons.end(); ++it ) (*it)->finish( appearanceManager, myappearance ? myappearance : defAppearance, params.tesselate );
-
-		bool finish = false;
-		while ( !finish && params.optimize ) 
-		{			
-			finish = true;
-			int len = (int)_polygons.size();			
-			for ( int i = 0; finish && i < len - 1; i++ ) 
-			{
-				for ( int j = i+1; finish && j < len - 1; j++ ) 
-				{
-					if ( !_polygons[i]->merge( _polygons[j] ) ) continue;
-					delete _polygons[j];
-					_polygons.erase( _polygons.begin() + j );
-					finish = false;		
-				}
-			}
-		}
-	}
-
-	bool Geometry::merge( Geometry* g ) 
-	{
-		if ( !g || g->_lod != _lod || g->_type != _type ) return false;
-
-		unsigned int pSize = g->_polygons.size();
-		for ( unsigned int i = 0; i < pSize; i++ )
-			_polygons.push_back( g->_polygons[i] );
-
-		g->_polygons.clear();
-
-		_id += "+" + g->_id;
-
-		return true;
-	}
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	std::string getCityObjectsClassName( CityObjectsTypeMask mask )
-	{
-#define GETCITYNAME( _t_ ) if ( mask & COT_ ## _t_ ) ss << # _t_ << "|";
-		std::stringstream ss;
-		GETCITYNAME( GenericCityObject );
-        GETCITYNAME( Building );
-		GETCITYNAME( BuildingPart );
-		GETCITYNAME( Room );
-		GETCITYNAME( BuildingInstallation );
-		GETCITYNAME( BuildingFurniture );
-		GETCITYNAME( Door );
-		GETCITYNAME( Window );
-		GETCITYNAME( CityFurniture );
-		GETCITYNAME( Track );
-		GETCITYNAME( Road );
-		GETCITYNAME( Railway );
-		GETCITYNAME( Square );
-		GETCITYNAME( PlantCover );
-		GETCITYNAME( SolitaryVegetationObject );
-		GETCITYNAME( WaterBody );
-		GETCITYNAME( TINRelief );
-		GETCITYNAME( LandUse );
-		GETCITYNAME( Tunnel );
-		GETCITYNAME( Bridge );
-		GETCITYNAME( BridgeConstructionElement );
-		GETCITYNAME( BridgeInstallation );
-		GETCITYNAME( BridgePart );
-		GETCITYNAME( RoofSurface );
-		GETCITYNAME( WallSurface );
-		GETCITYNAME( GroundSurface );
-		GETCITYNAME( ClosureSurface );      
-		GETCITYNAME( FloorSurface );        
-		GETCITYNAME( InteriorWallSurface );
-		GETCITYNAME( CeilingSurface );
-#undef GETCITYNAME
-		std::string s = ss.str();
-		if ( s != "" ) s.erase( s.length() - 1, 1 ); // remove the last | char
-		return s;
-	};
-
-	CityObjectsTypeMask getCityObjectsTypeMaskFromString( const std::string& stringMask ) 
-	{
-		CityObjectsTypeMask mask = 0;
-
-		std::vector<std::string> tokens = tokenize( stringMask );
-
-#define COMPARECITYNAMEMASK( _t_ ) {\
-	bool neg = ( tokens[i][0] == '~' || tokens[i][0] == '!' );\
-	if ( ci_string_compare( #_t_, neg ? tokens[i].substr(1) : tokens[i] ) ) { mask = neg ? ( mask & (~ COT_ ## _t_ )) : ( mask | COT_ ## _t_ );}\
-	}
-
-		for ( unsigned int i = 0; i < tokens.size(); i++ ) 
-		{
-			if ( tokens[i].length() == 0 ) continue;
-
-			COMPARECITYNAMEMASK( GenericCityObject );
-			COMPARECITYNAMEMASK( Building );
-			COMPARECITYNAMEMASK( BuildingPart );
-			COMPARECITYNAMEMASK( Room );
-			COMPARECITYNAMEMASK( BuildingInstallation );
-			COMPARECITYNAMEMASK( BuildingFurniture );
-			COMPARECITYNAMEMASK( Door );
-			COMPARECITYNAMEMASK( Window );
-			COMPARECITYNAMEMASK( CityFurniture );
-			COMPARECITYNAMEMASK( Track );				 
-			COMPARECITYNAMEMASK( Road );				 
-			COMPARECITYNAMEMASK( Railway );
-			COMPARECITYNAMEMASK( Square	);				 
-			COMPARECITYNAMEMASK( PlantCover	);
-			COMPARECITYNAMEMASK( SolitaryVegetationObject );
-			COMPARECITYNAMEMASK( WaterBody );
-			COMPARECITYNAMEMASK( TINRelief );					 
-			COMPARECITYNAMEMASK( LandUse );
-			COMPARECITYNAMEMASK( Tunnel );
-			COMPARECITYNAMEMASK( Bridge );
-			COMPARECITYNAMEMASK( BridgeConstructionElement );
-			COMPARECITYNAMEMASK( BridgeInstallation );
-			COMPARECITYNAMEMASK( BridgePart );
-			COMPARECITYNAMEMASK( GenericCityObject );
-
-			COMPARECITYNAMEMASK( WallSurface );
-			COMPARECITYNAMEMASK( RoofSurface );         
-			COMPARECITYNAMEMASK( GroundSurface );        
-			COMPARECITYNAMEMASK( ClosureSurface );      
-			COMPARECITYNAMEMASK( FloorSurface );        
-			COMPARECITYNAMEMASK( InteriorWallSurface );
-			COMPARECITYNAMEMASK( CeilingSurface );
-			COMPARECITYNAMEMASK( All );					
-		}
-#undef COMPARECITYNAMEMASK
-		return mask;
-	}
-
-	void CityObject::finish( AppearanceManager& appearanceManager, const ParserParams& params ) 
-	{
-		Appearance* myappearance = appearanceManager.getAppearance( getId() );
-		std::vector< Geometry* >::const_iterator it = _geometries.begin();
-		for ( ; it != _geometries.end(); ++it ) (*it)->finish( appearanceManager, myappearance ? myappearance : 0, params );
-
-		bool finish = false;
-		while ( !finish && params.optimize ) 
-		{
-			finish = true;
-			int len = _geometries.size();
-			for ( int i = 0; finish && i < len - 2; i++ ) 
-			{
-				for ( int j = i+1; finish && j < len - 1; j++ ) 
-				{
-					if ( !_geometries[i]->merge( _geometries[j] ) ) continue;
-					delete _geometries[j];					
-					_geometries.erase( _geometries.begin() + j );
-					finish = false;
-				}
-			}
-		}
-	}
-
-	///////////////////////////////////////////////////////////////////////////////
-
-	CityModel::~CityModel( void ) 
-	{ 	
-		CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
-		for ( ; it != _cityObjectsMap.end(); ++it ) 
-			for ( unsigned int i = 0; i < it->second.size(); i++ )
-				delete it->second[i];
-	}
-
-	void CityModel::addCityObject( CityObject* o )
-	{
-		CityObjectsMap::iterator it = _cityObjectsMap.find( o->getType() );
-		if ( it == _cityObjectsMap.end() )
-		{
-			CityObjects v;
-			v.push_back( o );
-			_cityObjectsMap[ o->getType() ] = v;
-		}
-		else
-			it->second.push_back( o );
-	}
-
-	void CityModel::finish( const ParserParams& params ) 
-	{
-		// Assign appearances to cityobjects => geometries => polygons
-		CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
-		for ( ; it != _cityObjectsMap.end(); ++it ) 
-			for ( unsigned int i = 0; i < it->second.size(); i++ )
-				it->second[i]->finish( _appearanceManager, params );
-
-		_appearanceManager.finish();
-	}
-}
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+ *
+ * Contributors:
+ *  - Manuel Garnier, BRGM - better normal computation
+ *
+ * This file is part of libcitygml library
+ * http://code.google.com/p/libcitygml
+ *
+ * libcitygml is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * libcitygml is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+*/
+
+#include "tesselator.h"
+#include "scheduler.h"
+#include "citygml.h"
+#include "utils.h"
+#include <string.h>
+#include <ctype.h>
+#include <limits>
+#include <iterator>
+#include <new>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+
+#ifndef min
+#	define min( a, b ) ( ( ( a ) < ( b ) ) ? ( a ) : ( b ) )
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace citygml
+{
+	std::ostream& operator<<( std::ostream& os, const Envelope& e ) 
+	{
+		return os << e.getLowerBound() << " " << e.getUpperBound();
+	}
+
+	std::ostream& operator<<( std::ostream& os, const Object& o ) 
+	{ 
+		return os << o.getId();
+	}
+
+	std::ostream& operator<<( std::ostream& os, const citygml::Geometry& s )
+	{
+		unsigned int count = 0;
+		for ( unsigned int i = 0; i < s.size(); i++ )
+		{
+			os << *s[i];
+			count += s[i]->getVertices().size();
+		}
+
+		os << "  @ " << s._polygons.size() << " polys [" << count << " vertices]" << std::endl;
+
+		return os;
+	}
+
+	std::ostream& operator<<( std::ostream& os, const CityObject& o ) 
+	{
+		os << o.getType() << ": " << o.getId() << std::endl;
+		os << "  Envelope: " << o.getEnvelope() << std::endl;
+
+		AttributesMap::const_iterator it = o._attributes.begin();
+		while ( it != o._attributes.end() )
+		{
+			os << "  + " << it->first << ": " << it->second << std::endl;
+			it++;
+		}
+
+		std::vector< Geometry* >::const_iterator itp = o._geometries.begin();
+		for ( ; itp != o._geometries.end(); itp++ ) 
+			os << **itp;
+
+		os << "  * " << o._geometries.size() << " geometries." << std::endl;
+
+		return os;
+	}
+
+	std::ostream& operator<<( std::ostream& out, const CityModel& model ) 
+	{
+		const CityObjectsMap& cityObjectsMap = model.getCityObjectsMap();
+
+		CityObjectsMap::const_iterator it = cityObjectsMap.begin();
+
+		for ( ; it != cityObjectsMap.end(); ++it )
+
+			for ( unsigned int i = 0; i < it->second.size(); i++ ) out << *(it->second[i]);
+
+		out << model.size() << " city objects." << std::endl;	
+
+		return out;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	ObjectArena::~ObjectArena( void )
+	{
+		for ( unsigned int i = 0; i < _blocks.size(); i++ ) free( _blocks[i] );
+	}
+
+	void* ObjectArena::allocate( size_t size )
+	{
+		const size_t align = 16;
+		size = ( size + align - 1 ) & ~( align - 1 );
+
+		if ( size > _remaining )
+		{
+			// Large requests get their own block so that the current one is not wasted
+			size_t blockSize = ( size > _blockSize / 4 ) ? size : _blockSize;
+			char* block = (char*)malloc( blockSize );
+			if ( !block ) throw std::bad_alloc();
+			_blocks.push_back( block );
+			_allocated += blockSize;
+			if ( blockSize == size ) return block;
+			_current = block;
+			_remaining = blockSize;
+		}
+
+		void* p = _current;
+		_current += size;
+		_remaining -= size;
+		return p;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// The synthetic ids are set through one of these mutexes, picked from the object address, and published by its flag
+	static std::mutex s_ptrIdLocks[ 64 ];
+
+	const std::string& Object::getPtrId( void ) const
+	{
+		if ( _hasPtrId.load( std::memory_order_acquire ) ) return _ptrId;
+
+		std::lock_guard<std::mutex> lock( s_ptrIdLocks[ ( (size_t)this / sizeof( Object ) ) % 64 ] );
+		if ( !_hasPtrId.load( std::memory_order_relaxed ) )
+		{
+			std::stringstream ss; 
+			ss << "PtrId_" << this; 
+			_ptrId = ss.str();
+			_hasPtrId.store( true, std::memory_order_release );
+		}
+		return _ptrId;
+	}
+
+	// Each object is preceded by a header telling the arena it was allocated from (0 for the heap),
+	// its size keeps the objects aligned as malloc does
+	union ObjectHeader
+	{
+		ObjectArena* arena;
+		double align[2];
+	};
+
+	void* Object::operator new( size_t size )
+	{
+		return operator new( size, 0 );
+	}
+
+	void* Object::operator new( size_t size, ObjectArena* arena )
+	{
+		size += sizeof( ObjectHeader );
+		ObjectHeader* header = (ObjectHeader*)( arena ? arena->allocate( size ) : malloc( size ) );
+		if ( !header ) throw std::bad_alloc();
+		header->arena = arena;
+		return header + 1;
+	}
+
+	void Object::operator delete( void* p )
+	{
+		if ( !p ) return;
+		ObjectHeader* header = (ObjectHeader*)p - 1;
+		if ( !header->arena ) free( header );
+	}
+
+	void Object::operator delete( void* p, ObjectArena* )
+	{
+		operator delete( p );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	static long long parseInteger( const std::string& text )
+	{
+		const char* c = text.c_str();
+		while ( isspace( *c ) ) c++;
+		bool neg = ( *c == '-' );
+		if ( *c == '-' || *c == '+' ) c++;
+		long long v = 0;
+		for ( ; *c >= '0' && *c <= '9'; c++ ) v = v * 10 + ( *c - '0' );
+		return neg ? -v : v;
+	}
+
+	AttributeValue::AttributeValue( const std::string& text, Type type ) : _type( type ), _text( text ), _integer( 0 )
+	{
+		switch ( _type )
+		{
+		case AT_Double: _double = strtod( _text.c_str(), 0 ); break;
+		case AT_Integer: _integer = parseInteger( _text ); break;
+		case AT_Date:
+			{
+				int year = 0, month = 0, day = 0;
+				if ( sscanf( _text.c_str(), "%d-%d-%d", &year, &month, &day ) >= 1 ) 
+					_integer = (long long)year * 10000 + month * 100 + day;
+			}
+			break;
+		default: break;
+		}
+	}
+
+	double AttributeValue::asDouble( void ) const
+	{
+		if ( _type == AT_Double ) return _double;
+		if ( _type == AT_Integer ) return (double)_integer;
+		return strtod( _text.c_str(), 0 );
+	}
+
+	long long AttributeValue::asInteger( void ) const
+	{
+		if ( _type == AT_Integer ) return _integer;
+		if ( _type == AT_Double ) return (long long)_double;
+		return parseInteger( _text );
+	}
+
+	bool AttributeValue::asDate( int& year, int& month, int& day ) const
+	{
+		if ( _type != AT_Date || _integer == 0 ) return false;
+		year = (int)( _integer / 10000 );
+		month = (int)( ( _integer / 100 ) % 100 );
+		day = (int)( _integer % 100 );
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	TVec3d LinearRing::computeNormal( void ) const
+	{
+		unsigned int len = size();
+		if ( len < 3 ) return TVec3d();
+
+		// Tampieri, F. 1992. Newell's method for computing the plane equation of a polygon. In Graphics Gems III, pp.231-232. 
+		TVec3d n( 0., 0., 0. );
+		for ( unsigned int i = 0; i < len; i++ )
+		{
+			const TVec3d& current = _vertices[i];
+			const TVec3d& next = _vertices[ ( i + 1 ) % len];
+
+			n.x += ( current.y - next.y ) * ( current.z + next.z );
+			n.y += ( current.z - next.z ) * ( current.x + next.x );
+			n.z += ( current.x - next.x ) * ( current.y + next.y );
+		}
+		return n.normal();
+	}
+
+	// Remove the duplicated consecutive vertices in a single pass, keeping the last vertex of each run of duplicates, 
+	// and the matching texture coordinates, which are stored in texCoords from texOffset
+	void LinearRing::finish( TexCoords* texCoords, unsigned int texOffset, double tolerance )
+	{
+		unsigned int len = _vertices.size();
+		if ( len < 2 ) return;
+
+		double sqrTolerance = tolerance * tolerance;
+
+		unsigned int texLen = 0;
+		if ( texCoords && texCoords->size() > texOffset ) texLen = min( (unsigned int)texCoords->size() - texOffset, len );
+		TVec2f* tex = texLen ? &(*texCoords)[ texOffset ] : 0;
+
+		unsigned int count = 0, texCount = 0;
+		for ( unsigned int i = 0; i < len; i++ )
+		{
+			if ( i + 1 < len && ( _vertices[i] - _vertices[i + 1] ).sqrLength() <= sqrTolerance ) continue;
+
+			// The previous kept vertices may now be duplicates of this one
+			while ( count > 0 && ( _vertices[count - 1] - _vertices[i] ).sqrLength() <= sqrTolerance ) count--;
+			texCount = min( texCount, count );
+
+			_vertices[count] = _vertices[i];
+			if ( i < texLen ) tex[texCount++] = tex[i];
+			count++;
+		}
+
+		// The closing point, usually a copy of the first one
+		while ( count > 1 && ( _vertices[count - 1] - _vertices[0] ).sqrLength() <= sqrTolerance ) count--;
+		texCount = min( texCount, count );
+
+		_vertices.resize( count );
+		if ( texLen ) texCoords->erase( texCoords->begin() + texOffset + texCount, texCoords->begin() + texOffset + texLen );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	AppearanceManager::AppearanceManager( StringPool& stringPool ) : _stringPool( stringPool ), _lastCoords( 0 ), _lastMaterial( 0 ), _lastTexture( 0 ) 
+	{
+		_tesselator = new ::Tesselator();
+	}
+
+	AppearanceManager::~AppearanceManager( void ) 
+	{
+		for ( unsigned int i = 0; i < _appearances.size(); i++ ) delete _appearances[i];
+
+		delete _tesselator;
+	}
+
+	void AppearanceManager::refresh( void )
+	{
+		_lastCoords = 0;
+		_lastId = InternedString();
+	}
+
+	void AppearanceManager::addAppearance( Material* mat ) 
+	{ 
+		if ( !mat ) return;
+		_appearances.push_back( mat ); 
+		_lastMaterial = mat;
+		_lastTexture = 0;
+	}
+
+	void AppearanceManager::addAppearance( Texture* tex ) 
+	{ 
+		if ( !tex ) return;
+		_appearances.push_back( tex ); 
+		_lastMaterial = 0;
+		_lastTexture = tex;
+	}
+
+	void AppearanceManager::assignNode( const std::string& nodeid )
+	{ 
+		InternedString node = _stringPool.intern( nodeid );
+		_lastId = node; 
+
+		NodeAppearances& slots = _appearancesMap[ node.get() ];
+
+		// Only the first appearance of each type & side is kept for a node
+		Appearance* currentAppearance = _lastMaterial ? static_cast< Appearance* >( _lastMaterial ) : _lastTexture;
+		if ( !currentAppearance ) return;
+		unsigned int side = currentAppearance->getIsFront() ? 0 : 1;
+		if ( _lastMaterial && !slots.materials[ side ] ) slots.materials[ side ] = _lastMaterial;
+		else if ( _lastTexture && !slots.textures[ side ] ) slots.textures[ side ] = _lastTexture;
+		else return;
+
+		if ( !slots.appearance ) slots.appearance = currentAppearance;
+		if ( _lastCoords ) { assignTexCoords( _lastCoords ); _lastId = InternedString(); }
+	}
+
+	// Pool the parsed coordinates (the list is moved from) and assign them to the last targeted node
+	bool AppearanceManager::assignTexCoords( TexCoords& tex ) 
+	{
+		return assignTexCoords( _texCoordsPool.intern( tex ) );
+	}
+
+	bool AppearanceManager::assignTexCoords( const TexCoords* tex ) 
+	{ 
+		_lastCoords = tex;
+		// Kept pending until a node is targeted
+		if ( _lastId.isNull() || _lastId.str() == "" ) return false;
+
+		_texCoordsMap[ _lastId.get() ] = tex; 
+		_lastCoords = 0;
+		_lastId = InternedString();
+		return true;
+	}
+
+    void AppearanceManager::finish(void)
+    {
+		_appearancesMap.clear();
+		_lastMaterial = 0;
+		_lastTexture = 0;
+        _texCoordsMap.clear();
+		_lastCoords = 0;
+    }
+		
+	///////////////////////////////////////////////////////////////////////////////
+
+	Polygon::~Polygon( void ) 
+	{ 
+		delete _exteriorRing;
+		std::vector< LinearRing* >::const_iterator it = _interiorRings.begin();
+		for ( ; it != _interiorRings.end(); ++it ) delete *it;
+	}
+
+	TVec3d Polygon::computeNormal( void ) 
+	{
+		if ( !_exteriorRing ) return TVec3d();
+
+		TVec3d normal = _exteriorRing->computeNormal();
+
+		return _negNormal ? -normal : normal;
+	}
+
+	// Resolve the rings texture coordinates & remove their duplicated vertices, while the appearances are still available.
+	// The rings without their own texture coordinates use the polygon ones, which follow the rings vertices.
+	void Polygon::finishRings( AppearanceManager &appearanceManager, double tolerance )
+	{
+		if ( !_exteriorRing ) return;
+
+		unsigned int offset = 0;
+		for ( unsigned int i = 0; i <= _interiorRings.size(); i++ ) 
+		{
+			LinearRing* ring = ( i == 0 ) ? _exteriorRing : _interiorRings[i - 1];
+
+			// The ring own texture coordinates are copied once, straight to their place in the polygon ones
+			const TexCoords* texCoords = ring->hasId() ? appearanceManager.getTexCoords( appearanceManager.getNode( ring->_id ) ) : 0;
+			if ( texCoords ) 
+			{
+				_texCoords.resize( offset );
+				_texCoords.insert( _texCoords.end(), texCoords->begin(), texCoords->end() );
+				_pooledTexCoords = ( i == 0 ) ? texCoords : 0;
+			}
+
+			ring->finish( &_texCoords, offset, tolerance );
+			offset += ring->size();
+		}
+	}
+
+	void Polygon::tesselate( Tesselator* tess )
+	{
+		_indices.clear();
+
+		if ( !_useTesselator ) 
+		{ 
+			mergeRings();
+		}
+		else if ( tesselateConvex() )
+		{
+			clearRings();
+		}
+		else
+		{
+			// Compute the total number of vertices
+			unsigned int vsize = _exteriorRing->size();
+			for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
+				vsize += _interiorRings[i]->size();
+
+			// The tesselator writes straight into the polygon buffers
+			tess->init( vsize, TVec3d( _normal.x, _normal.y, _normal.z ), _vertices, _indices );
+
+			tess->addContour( _exteriorRing->getVertices() );
+
+			for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
+				tess->addContour( _interiorRings[i]->getVertices() ); 
+
+			tess->compute();
+			clearRings();
+		}
+
+		// The texture coordinates, if any, follow the vertices
+		if ( !_texCoords.empty() ) _texCoords.resize( _vertices.size() );
+	}
+
+	// Fast path for the triangles, quads & other convex polygons without holes: fan triangulation of the exterior ring.
+	// The ring is convex when, projected on its dominant plane, all its turns have the same sign and its edges
+	// direction changes at most twice along each axis (otherwise it winds more than once).
+	bool Polygon::tesselateConvex( void )
+	{
+		if ( !_interiorRings.empty() ) return false;
+
+		const std::vector<TVec3d>& vertices = _exteriorRing->getVertices();
+		unsigned int len = vertices.size();
+		if ( len < 3 ) return false;
+
+		int u, v;
+		Tesselator::getProjectionAxes( TVec3d( _normal.x, _normal.y, _normal.z ), u, v );
+
+		int turn = 0, flipsU = 0, flipsV = 0;
+		int firstU = 0, firstV = 0, lastU = 0, lastV = 0;
+		for ( unsigned int i = 0; i < len; i++ )
+		{
+			const TVec3d& a = vertices[ i ];
+			const TVec3d& b = vertices[ ( i + 1 ) % len ];
+			const TVec3d& c = vertices[ ( i + 2 ) % len ];
+
+			double du = b[u] - a[u], dv = b[v] - a[v];
+			double cross = du * ( c[v] - b[v] ) - dv * ( c[u] - b[u] );
+			if ( cross == 0 ) return false;
+
+			int s = ( cross > 0 ) ? 1 : -1;
+			if ( turn && s != turn ) return false;
+			turn = s;
+
+			int su = ( du > 0 ) - ( du < 0 ), sv = ( dv > 0 ) - ( dv < 0 );
+			if ( su ) { if ( lastU && su != lastU ) flipsU++; lastU = su; if ( !firstU ) firstU = su; }
+			if ( sv ) { if ( lastV && sv != lastV ) flipsV++; lastV = sv; if ( !firstV ) firstV = sv; }
+		}
+		if ( firstU != lastU ) flipsU++;
+		if ( firstV != lastV ) flipsV++;
+		if ( flipsU > 2 || flipsV > 2 ) return false;
+
+		// The ring is about to be released: take its vertices over
+		_vertices.swap( _exteriorRing->getVertices() );
+
+		// Keep the triangles counter-clockwise as seen from the normal
+		_indices.resize( 3 * ( len - 2 ) );
+		unsigned int* idx = &_indices[0];
+		for ( unsigned int i = 1; i + 1 < len; i++, idx += 3 )
+		{
+			idx[0] = 0;
+			idx[1] = ( turn > 0 ) ? i : i + 1;
+			idx[2] = ( turn > 0 ) ? i + 1 : i;
+		}
+		return true;
+	}
+
+	// Lazy tesselation: the polygon is locked through one of these mutexes, picked from its address, and tesselated with a per-thread tesselator
+	static std::mutex s_tesselationLocks[ 64 ];
+
+	void Polygon::tesselateOnDemand( void ) const
+	{
+		std::lock_guard<std::mutex> lock( s_tesselationLocks[ ( (size_t)this / sizeof( Polygon ) ) % 64 ] );
+		if ( !_pendingTesselation.load( std::memory_order_relaxed ) ) return;
+
+		static thread_local ::Tesselator tesselator;
+		const_cast<Polygon*>( this )->tesselate( &tesselator );
+
+		_pendingTesselation.store( false, std::memory_order_release );
+	}
+
+	static inline void extendBounds( TVec3d& lower, TVec3d& upper, const TVec3d* vertices, unsigned int count )
+	{
+		for ( unsigned int i = 0; i < count; i++ )
+			for ( unsigned int j = 0; j < 3; j++ )
+			{
+				if ( vertices[i][j] < lower[j] ) lower[j] = vertices[i][j];
+				if ( vertices[i][j] > upper[j] ) upper[j] = vertices[i][j];
+			}
+	}
+
+	void Polygon::extendBounds( TVec3d& lower, TVec3d& upper ) const
+	{
+		if ( isTesselationPending() )
+		{
+			// Locked since a concurrent tesselation releases the rings
+			std::lock_guard<std::mutex> lock( s_tesselationLocks[ ( (size_t)this / sizeof( Polygon ) ) % 64 ] );
+			if ( _pendingTesselation.load( std::memory_order_relaxed ) )
+			{
+				if ( _exteriorRing && _exteriorRing->size() > 0 ) citygml::extendBounds( lower, upper, &_exteriorRing->getVertices()[0], _exteriorRing->size() );
+				for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
+					if ( _interiorRings[i]->size() > 0 ) citygml::extendBounds( lower, upper, &_interiorRings[i]->getVertices()[0], _interiorRings[i]->size() );
+				return;
+			}
+		}
+
+		ArrayView<TVec3d> vertices = getVertices();
+		if ( !vertices.empty() ) citygml::extendBounds( lower, upper, &vertices[0], vertices.size() );
+	}
+
+	void Polygon::mergeRings( void )
+	{
+		_indices.clear();
+		if ( !_exteriorRing ) return;
+
+		_vertices.reserve( _vertices.size() + _exteriorRing->size() );
+		std::copy( _exteriorRing->getVertices().begin(), _exteriorRing->getVertices().end(), std::back_inserter( _vertices ) );
+
+		for ( unsigned int i = 0; i < _interiorRings.size(); i++ )
+		{
+			_vertices.reserve( _vertices.size() + _interiorRings[i]->size() );
+			std::copy( _interiorRings[i]->getVertices().begin(), _interiorRings[i]->getVertices().end(), std::back_inserter( _vertices ) );
+		}
+		clearRings();
+
+		if ( _vertices.size() < 3 ) return;
+
+		// Create triangles' indices
+		int indicesSize = 3 * ( _vertices.size() - 2 );
+		if ( indicesSize < 3 ) return;
+		_indices.resize( indicesSize );
+		for ( int i = 0, p = 0; p < indicesSize - 2; i++, p += 3 )
+			for ( unsigned int j = 0; j < 3; j++ )
+				_indices[ p + j ] = i + j;
+	}
+
+	void Polygon::clearRings( void )
+	{
+		delete _exteriorRing;
+		_exteriorRing = 0;
+		for ( unsigned int i = 0; i < _interiorRings.size(); i++ ) delete _interiorRings[i]; 
+		_interiorRings.clear();
+	}
+
+	// Merge polygon p into the current polygon
+	// Append the polygons, which share this polygon appearance, sizing the buffers once; their ids & ranges are kept in the sources table
+	void Polygon::merge( const std::vector< Polygon* >& polygons )
+	{
+		unsigned int vSize = _vertices.size(), iSize = _indices.size(), sSize = _sources.empty() ? 1 : _sources.size();
+		bool uniform = hasUniformNormal(), textured = !_texCoords.empty();
+		for ( unsigned int k = 0; k < polygons.size(); k++ )
+		{
+			const Polygon* p = polygons[k];
+			if ( p->_vertices.empty() ) continue;
+			vSize += p->_vertices.size();
+			iSize += p->_indices.size();
+			sSize += p->_sources.empty() ? 1 : p->_sources.size();
+			uniform = uniform && p->hasUniformNormal() && p->_normal == _normal;
+			textured = textured || !p->_texCoords.empty();
+		}
+		if ( vSize == _vertices.size() ) return;
+
+		if ( _sources.empty() ) _sources.push_back( PolygonRange( _id, 0, _vertices.size(), 0, _indices.size() ) );
+		_sources.reserve( sSize );
+
+		// Normals are only expanded per vertex if the polygons orientations differ
+		if ( !uniform ) 
+		{
+			if ( hasUniformNormal() ) _normals.assign( _vertices.size(), _normal );
+			_normals.reserve( vSize );
+		}
+
+		// Texture coordinates are only padded if some of the polygons have them
+		if ( textured )
+		{
+			_texCoords.resize( _vertices.size() );
+			_texCoords.reserve( vSize );
+		}
+		_vertices.reserve( vSize );
+		_indices.reserve( iSize );
+
+		for ( unsigned int k = 0; k < polygons.size(); k++ )
+		{
+			Polygon* p = polygons[k];
+			unsigned int pVSize = p->_vertices.size();
+			if ( pVSize == 0 ) continue;
+
+			unsigned int vOffset = _vertices.size(), iOffset = _indices.size();
+
+			_vertices.insert( _vertices.end(), p->_vertices.begin(), p->_vertices.end() );
+
+			for ( unsigned int i = 0; i < p->_indices.size(); i++ ) _indices.push_back( vOffset + p->_indices[i] );
+
+			if ( !uniform )
+			{
+				if ( p->hasUniformNormal() ) _normals.insert( _normals.end(), pVSize, p->_normal );
+				else _normals.insert( _normals.end(), p->_normals.begin(), p->_normals.end() );
+			}
+
+			if ( textured )
+			{
+				_texCoords.insert( _texCoords.end(), p->_texCoords.begin(), p->_texCoords.begin() + min( (unsigned int)p->_texCoords.size(), pVSize ) );
+				_texCoords.resize( _vertices.size() );
+			}
+
+			if ( p->_sources.empty() ) 
+				_sources.push_back( PolygonRange( p->_id, vOffset, pVSize, iOffset, p->_indices.size() ) );
+			else for ( unsigned int i = 0; i < p->_sources.size(); i++ )
+			{
+				PolygonRange range = p->_sources[i];
+				range.vertexOffset += vOffset;
+				range.indexOffset += iOffset;
+				_sources.push_back( range );
+			}
+
+			std::vector<TVec3d>().swap( p->_vertices );
+			std::vector<unsigned int>().swap( p->_indices );
+			std::vector<TVec3f>().swap( p->_normals );
+			TexCoords().swap( p->_texCoords );
+		}
+	}
+
+	void Polygon::finish( AppearanceManager& appearanceManager, Tesselator* tesselator, const ParserParams& params ) 
+	{
+		TVec3d normal = computeNormal();
+		_normal = TVec3f( (float)normal.x, (float)normal.y, (float)normal.z );
+
+		// Degenerated exterior rings are merged rather than tesselated
+		_useTesselator = params.tesselate && _exteriorRing && _exteriorRing->size() >= 3;
+
+		finishRings( appearanceManager, params.vertexTolerance );
+
+		// Merging needs the tesselated polygons
+		if ( params.lazyTesselation && !params.optimize ) _pendingTesselation.store( true, std::memory_order_release ); else tesselate( tesselator );
+	}
+
+	void Polygon::finish( AppearanceManager& appearanceManager, Tesselator* tesselator, const AppearanceManager::NodeAppearances* defAppearances, const ParserParams& params )
+	{	
+		// Polygons without id cannot be targeted by any appearance
+		InternedString node = hasId() ? appearanceManager.getNode( _id ) : InternedString();
+
+		const TexCoords* texCoords = appearanceManager.getTexCoords( node );
+		if ( !texCoords && _geometry->hasId() ) texCoords = appearanceManager.getTexCoords( appearanceManager.getNode( _geometry->getId() ) );
+		if ( texCoords ) _texCoords = *texCoords; else _texCoords.clear();
+		_pooledTexCoords = texCoords;
+				
+		finish( appearanceManager, tesselator, params );
+		
+		if ( const AppearanceManager::NodeAppearances* slots = appearanceManager.getNodeAppearances( node ) )
+		{
+			_appearance = slots->appearance;
+			_materials[ FRONT ] = slots->getMaterial( AppearanceManager::FS_FRONT );
+			_materials[ BACK ] = slots->getMaterial( AppearanceManager::FS_BACK );
+			_texture = slots->getTexture( AppearanceManager::FS_ANY );
+		}
+
+		if ( !defAppearances ) return;
+
+		// The default appearance is the first one assigned to the geometry or else to the object
+		if ( !_appearance ) _appearance = defAppearances->appearance;
+
+ 		if ( !_materials[ FRONT ]  && !_materials[ BACK ])
+ 			_materials[ FRONT ] = defAppearances->getFirstMaterial();
+
+		if ( !_texture ) _texture = defAppearances->getFirstTexture();
+	}
+
+	// Move the polygon data out of its own vectors, to the shared buffers if any or else to the arena
+	void Polygon::pack( ObjectArena& arena, GeometryBuffers* buffers )
+	{
+		// The untextured polygons keep no texture coordinates
+		if ( !_texCoords.empty() ) _texCoords.resize( _vertices.size() );
+
+		// Out of the shared buffers, the texture coordinates still matching the head of their pooled list (ie. the tesselation
+		// added no vertex and the ring only lost its closing point) point to it rather than being copied
+		if ( buffers || _texCoords.empty() || !_pooledTexCoords || _pooledTexCoords->size() < _texCoords.size() 
+			|| !std::equal( _texCoords.begin(), _texCoords.end(), _pooledTexCoords->begin() ) ) _pooledTexCoords = 0;
+
+		if ( buffers )
+		{
+			unsigned int vertexOffset = buffers->_vertices.size(), texCoordOffset = buffers->_texCoords.size(), indexOffset = buffers->_indices.size();
+			buffers->_vertices.insert( buffers->_vertices.end(), _vertices.begin(), _vertices.end() );
+			buffers->_texCoords.insert( buffers->_texCoords.end(), _texCoords.begin(), _texCoords.end() );
+			buffers->_indices.insert( buffers->_indices.end(), _indices.begin(), _indices.end() );
+			setBuffers( *buffers, vertexOffset, _vertices.size(), indexOffset, _indices.size() );
+			if ( !_texCoords.empty() ) setTexCoordsBuffer( *buffers, texCoordOffset );
+		}
+		else
+		{
+			_vertexCount = _vertices.size();
+			_indexCount = _indices.size();
+			_packedVertices = arena.copy( _vertices.data(), _vertexCount );
+			if ( _pooledTexCoords ) _packedTexCoords = const_cast< TVec2f* >( _pooledTexCoords->data() );
+			else if ( !_texCoords.empty() ) _packedTexCoords = arena.copy( _texCoords.data(), _vertexCount );
+			_packedIndices = arena.copy( _indices.data(), _indexCount );
+		}
+
+		if ( !_normals.empty() ) _packedNormals = arena.copy( _normals.data(), _vertexCount );
+
+		std::vector<TVec3d>().swap( _vertices );
+		TexCoords().swap( _texCoords );
+		std::vector<unsigned int>().swap( _indices );
+		std::vector<TVec3f>().swap( _normals );
+	}
+
+	// Point the polygon to its range of the shared buffers, which must not be resized anymore
+	void Polygon::setBuffers( GeometryBuffers& buffers, unsigned int vertexOffset, unsigned int vertexCount, unsigned int indexOffset, unsigned int indexCount )
+	{
+		_vertexOffset = vertexOffset;
+		_vertexCount = vertexCount;
+		_indexOffset = indexOffset;
+		_indexCount = indexCount;
+
+		_packedVertices = GeometryBuffers::at( buffers._vertices, vertexOffset );
+		_packedIndices = GeometryBuffers::at( buffers._indices, indexOffset );
+	}
+
+	// Point the textured polygon to its texture coordinates in the shared buffers, one per vertex
+	void Polygon::setTexCoordsBuffer( GeometryBuffers& buffers, unsigned int texCoordOffset )
+	{
+		_texCoordOffset = texCoordOffset;
+		_packedTexCoords = GeometryBuffers::at( buffers._texCoords, texCoordOffset );
+	}
+
+	void Polygon::addRing( LinearRing* ring ) 
+	{
+		if ( ring->isExterior() ) _exteriorRing = ring;
+		else _interiorRings.push_back( ring );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	Geometry::~Geometry() 
+	{ 
+		std::vector< Polygon* >::const_iterator it = _polygons.begin();
+		for ( ; it != _polygons.end(); ++it ) delete *it;
+	}
+
+	void Geometry::addPolygon( Polygon* p ) 
+	{ 
+		p->_geometry = this;
+		_polygons.push_back( p ); 
+	}
+
+	template< class T > static inline size_t hashCombine( size_t seed, const T& v )
+	{
+		return seed ^ ( std::hash< T >()( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 ) );
+	}
+
+	// Appearances of a polygon, which must all match for polygons to be merged
+	struct PolygonAppearances
+	{
+		PolygonAppearances( const Polygon* p ) : appearance( p->getAppearance() ), front( p->getMaterialFront() ), back( p->getMaterialBack() ), texture( p->getTexture() ) {}
+
+		inline bool operator==( const PolygonAppearances& a ) const 
+		{ 
+			return appearance == a.appearance && front == a.front && back == a.back && texture == a.texture; 
+		}
+
+		struct Hash
+		{
+			inline size_t operator()( const PolygonAppearances& a ) const
+			{
+				return hashCombine( hashCombine( hashCombine( hashCombine( 0, a.appearance ), a.front ), a.back ), a.texture );
+			}
+		};
+
+		const void* appearance;
+		const void* front;
+		const void* back;
+		const void* texture;
+	};
+
+	// Finish the polygons [first, last), defAppearances being the geometry appearances or else its object ones
+	void Geometry::finish( AppearanceManager& appearanceManager, Tesselator* tesselator, const AppearanceManager::NodeAppearances* defAppearances, const ParserParams& params, unsigned int first, unsigned int last )
+	{
+		for ( unsigned int i = first; i < last; i++ ) 
+			_polygons[i]->finish( appearanceManager, tesselator, defAppearances, params );
+	}
+
+	// Merge the polygons sharing the same appearances into the first of them, grouping them in a single hashing pass
+	void Geometry::optimize( void )
+	{
+		std::unordered_map< PolygonAppearances, unsigned int, PolygonAppearances::Hash > groups;
+		std::vector< Polygon* > polygons;
+		std::vector< std::vector< Polygon* > > merged;
+
+		for ( unsigned int i = 0; i < _polygons.size(); i++ )
+		{
+			Polygon* p = _polygons[i];
+			std::pair< std::unordered_map< PolygonAppearances, unsigned int, PolygonAppearances::Hash >::iterator, bool > it = 
+				groups.insert( std::make_pair( PolygonAppearances( p ), (unsigned int)polygons.size() ) );
+			if ( it.second ) 
+			{
+				polygons.push_back( p );
+				merged.push_back( std::vector< Polygon* >() );
+			}
+			else merged[ it.first->second ].push_back( p );
+		}
+
+		for ( unsigned int i = 0; i < polygons.size(); i++ )
+		{
+			polygons[i]->merge( merged[i] );
+			for ( unsigned int j = 0; j < merged[i].size(); j++ ) delete merged[i][j];
+		}
+
+		_polygons.swap( polygons );
+	}
+
+	// Append the polygons of the given geometries, which share this geometry LOD & type
+	void Geometry::merge( const std::vector< Geometry* >& geometries ) 
+	{
+		unsigned int size = _polygons.size();
+		for ( unsigned int i = 0; i < geometries.size(); i++ ) size += geometries[i]->_polygons.size();
+		_polygons.reserve( size );
+
+		for ( unsigned int i = 0; i < geometries.size(); i++ )
+		{
+			Geometry* g = geometries[i];
+			for ( unsigned int j = 0; j < g->_polygons.size(); j++ ) g->_polygons[j]->_geometry = this;
+			_polygons.insert( _polygons.end(), g->_polygons.begin(), g->_polygons.end() );
+			g->_polygons.clear();
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	std::string getCityObjectsClassName( CityObjectsTypeMask mask )
+	{
+#define GETCITYNAME( _t_ ) if ( mask & COT_ ## _t_ ) ss << # _t_ << "|";
+		std::stringstream ss;
+		GETCITYNAME( GenericCityObject );
+        GETCITYNAME( Building );
+		GETCITYNAME( BuildingPart );
+		GETCITYNAME( Room );
+		GETCITYNAME( BuildingInstallation );
+		GETCITYNAME( BuildingFurniture );
+		GETCITYNAME( Door );
+		GETCITYNAME( Window );
+		GETCITYNAME( CityFurniture );
+		GETCITYNAME( Track );
+		GETCITYNAME( Road );
+		GETCITYNAME( Railway );
+		GETCITYNAME( Square );
+		GETCITYNAME( PlantCover );
+		GETCITYNAME( SolitaryVegetationObject );
+		GETCITYNAME( WaterBody );
+		GETCITYNAME( TINRelief );
+		GETCITYNAME( LandUse );
+		GETCITYNAME( Tunnel );
+		GETCITYNAME( Bridge );
+		GETCITYNAME( BridgeConstructionElement );
+		GETCITYNAME( BridgeInstallation );
+		GETCITYNAME( BridgePart );
+		GETCITYNAME( RoofSurface );
+		GETCITYNAME( WallSurface );
+		GETCITYNAME( GroundSurface );
+		GETCITYNAME( ClosureSurface );      
+		GETCITYNAME( FloorSurface );        
+		GETCITYNAME( InteriorWallSurface );
+		GETCITYNAME( CeilingSurface );
+#undef GETCITYNAME
+		std::string s = ss.str();
+		if ( s != "" ) s.erase( s.length() - 1, 1 ); // remove the last | char
+		return s;
+	};
+
+	CityObjectsTypeMask getCityObjectsTypeMaskFromString( const std::string& stringMask ) 
+	{
+		CityObjectsTypeMask mask = 0;
+
+		std::vector<std::string> tokens = tokenize( stringMask );
+
+#define COMPARECITYNAMEMASK( _t_ ) {\
+	bool neg = ( tokens[i][0] == '~' || tokens[i][0] == '!' );\
+	if ( ci_string_compare( #_t_, neg ? tokens[i].substr(1) : tokens[i] ) ) { mask = neg ? ( mask & (~ COT_ ## _t_ )) : ( mask | COT_ ## _t_ );}\
+	}
+
+		for ( unsigned int i = 0; i < tokens.size(); i++ ) 
+		{
+			if ( tokens[i].length() == 0 ) continue;
+
+			COMPARECITYNAMEMASK( GenericCityObject );
+			COMPARECITYNAMEMASK( Building );
+			COMPARECITYNAMEMASK( BuildingPart );
+			COMPARECITYNAMEMASK( Room );
+			COMPARECITYNAMEMASK( BuildingInstallation );
+			COMPARECITYNAMEMASK( BuildingFurniture );
+			COMPARECITYNAMEMASK( Door );
+			COMPARECITYNAMEMASK( Window );
+			COMPARECITYNAMEMASK( CityFurniture );
+			COMPARECITYNAMEMASK( Track );				 
+			COMPARECITYNAMEMASK( Road );				 
+			COMPARECITYNAMEMASK( Railway );
+			COMPARECITYNAMEMASK( Square	);				 
+			COMPARECITYNAMEMASK( PlantCover	);
+			COMPARECITYNAMEMASK( SolitaryVegetationObject );
+			COMPARECITYNAMEMASK( WaterBody );
+			COMPARECITYNAMEMASK( TINRelief );					 
+			COMPARECITYNAMEMASK( LandUse );
+			COMPARECITYNAMEMASK( Tunnel );
+			COMPARECITYNAMEMASK( Bridge );
+			COMPARECITYNAMEMASK( BridgeConstructionElement );
+			COMPARECITYNAMEMASK( BridgeInstallation );
+			COMPARECITYNAMEMASK( BridgePart );
+			COMPARECITYNAMEMASK( GenericCityObject );
+
+			COMPARECITYNAMEMASK( WallSurface );
+			COMPARECITYNAMEMASK( RoofSurface );         
+			COMPARECITYNAMEMASK( GroundSurface );        
+			COMPARECITYNAMEMASK( ClosureSurface );      
+			COMPARECITYNAMEMASK( FloorSurface );        
+			COMPARECITYNAMEMASK( InteriorWallSurface );
+			COMPARECITYNAMEMASK( CeilingSurface );
+			COMPARECITYNAMEMASK( All );					
+		}
+#undef COMPARECITYNAMEMASK
+		return mask;
+	}
+
+	// Merge the geometries of the same LOD & type into the first of them, grouping them in a single hashing pass, then merge their polygons
+	void CityObject::optimize( bool mergeChildren ) 
+	{
+		if ( mergeChildren )
+			for ( unsigned int i = 0; i < _children.size(); i++ ) _children[i]->moveGeometries( _geometries );
+
+		std::unordered_map< unsigned int, unsigned int > groups;
+		std::vector< Geometry* > geometries;
+		std::vector< std::vector< Geometry* > > merged;
+
+		for ( unsigned int i = 0; i < _geometries.size(); i++ )
+		{
+			Geometry* g = _geometries[i];
+			std::pair< std::unordered_map< unsigned int, unsigned int >::iterator, bool > it = 
+				groups.insert( std::make_pair( ( g->_lod << 16 ) | g->_type, (unsigned int)geometries.size() ) );
+			if ( it.second ) 
+			{
+				geometries.push_back( g );
+				merged.push_back( std::vector< Geometry* >() );
+			}
+			else merged[ it.first->second ].push_back( g );
+		}
+
+		for ( unsigned int i = 0; i < geometries.size(); i++ )
+		{
+			geometries[i]->merge( merged[i] );
+			for ( unsigned int j = 0; j < merged[i].size(); j++ ) delete merged[i][j];
+			geometries[i]->optimize();
+		}
+
+		_geometries.swap( geometries );
+	}
+
+	// Move the geometries of the object & of its descendants to the given list
+	void CityObject::moveGeometries( std::vector< Geometry* >& geometries )
+	{
+		geometries.insert( geometries.end(), _geometries.begin(), _geometries.end() );
+		_geometries.clear();
+
+		for ( unsigned int i = 0; i < _children.size(); i++ ) _children[i]->moveGeometries( geometries );
+	}
+
+	unsigned int CityObject::getPolygonsCount( bool recursive ) const
+	{
+		unsigned int count = 0;
+		for ( unsigned int i = 0; i < _geometries.size(); i++ ) count += _geometries[i]->_polygons.size();
+
+		if ( recursive )
+			for ( unsigned int i = 0; i < _children.size(); i++ ) count += _children[i]->getPolygonsCount( true );
+
+		return count;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	CityModel::~CityModel( void ) 
+	{ 	
+		delete _spatialIndex;
+
+		CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
+		for ( ; it != _cityObjectsMap.end(); ++it ) 
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+				delete it->second[i];
+	}
+
+	void CityModel::addCityObject( CityObject* o )
+	{
+		CityObjectsMap::iterator it = _cityObjectsMap.find( o->getType() );
+		if ( it == _cityObjectsMap.end() )
+		{
+			CityObjects v;
+			v.push_back( o );
+			_cityObjectsMap[ o->getType() ] = v;
+		}
+		else
+			it->second.push_back( o );
+	}
+
+	void CityModel::finish( const ParserParams& params ) 
+	{
+		Scheduler scheduler( params.threads );
+
+		std::vector< Tesselator* > tesselators( scheduler.getWorkersCount(), 0 );
+		tesselators[0] = _appearanceManager.getTesselator();
+		for ( unsigned int i = 1; i < tesselators.size(); i++ ) tesselators[i] = new Tesselator();
+
+		// Gather the geometries with their default appearance & the cost (ie. vertices count) of their polygons
+		std::vector< CityObject* > objects;
+		objects.reserve( size() );
+		CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
+		for ( ; it != _cityObjectsMap.end(); ++it ) 
+			objects.insert( objects.end(), it->second.begin(), it->second.end() );
+
+		std::vector< std::pair< Geometry*, const AppearanceManager::NodeAppearances* > > geometries;
+		std::vector< unsigned int > costs;
+		size_t totalCost = 0;
+		for ( unsigned int i = 0; i < objects.size(); i++ )
+		{
+			CityObject* obj = objects[i];
+			const AppearanceManager::NodeAppearances* objAppearances = obj->hasId() ? _appearanceManager.getNodeAppearances( _appearanceManager.getNode( obj->_id ) ) : 0;
+			if ( objAppearances && !objAppearances->appearance ) objAppearances = 0;
+			for ( unsigned int j = 0; j < obj->_geometries.size(); j++ )
+			{
+				Geometry* geom = obj->_geometries[j];
+				const AppearanceManager::NodeAppearances* geomAppearances = ( geom->hasId() || geom->_inlineAppearance ) ? _appearanceManager.getNodeAppearances( _appearanceManager.getNode( geom->getId() ) ) : 0;
+				geometries.push_back( std::make_pair( geom, ( geomAppearances && geomAppearances->appearance ) ? geomAppearances : objAppearances ) );
+				for ( unsigned int k = 0; k < geom->_polygons.size(); k++ )
+				{
+					costs.push_back( geom->_polygons[k]->getRingsVerticesCount() );
+					totalCost += costs.back();
+				}
+			}
+		}
+
+		// Assign appearances to polygons & tesselate them, by batches of polygons of similar cost 
+		// so that the huge geometries (eg. TIN reliefs) get spread among the workers
+		size_t batchCost = std::max( totalCost / ( scheduler.getWorkersCount() * 64 ), (size_t)256 );
+		unsigned int p = 0;
+		for ( unsigned int i = 0; i < geometries.size(); i++ )
+		{
+			Geometry* geom = geometries[i].first;
+			const AppearanceManager::NodeAppearances* defAppearances = geometries[i].second;
+			unsigned int len = geom->_polygons.size();
+			for ( unsigned int first = 0; first < len; )
+			{
+				unsigned int last = first;
+				size_t cost = 0;
+				while ( last < len && ( last == first || cost < batchCost ) ) cost += costs[ p + last++ ];
+
+				scheduler.add( [this, geom, defAppearances, first, last, &tesselators, &params]( unsigned int worker ) 
+				{ 
+					geom->finish( _appearanceManager, tesselators[worker], defAppearances, params, first, last ); 
+				}, cost );
+
+				first = last;
+			}
+			p += len;
+		}
+		scheduler.run();
+
+		// Then merge the objects polygons & geometries
+		if ( params.optimize )
+		{
+			// The children merged into their parent are not optimized on their own
+			std::unordered_set< const CityObject* > children;
+			if ( params.mergeChildren )
+				for ( unsigned int i = 0; i < objects.size(); i++ ) children.insert( objects[i]->_children.begin(), objects[i]->_children.end() );
+
+			bool mergeChildren = params.mergeChildren;
+			for ( unsigned int i = 0; i < objects.size(); i++ )
+			{
+				CityObject* obj = objects[i];
+				if ( children.count( obj ) ) continue;
+				scheduler.add( [obj, mergeChildren]( unsigned int ) { obj->optimize( mergeChildren ); }, obj->getPolygonsCount( mergeChildren ) );
+			}
+			scheduler.run();
+		}
+
+		for ( unsigned int i = 1; i < tesselators.size(); i++ ) delete tesselators[i];
+
+		_finishStats = scheduler.getStats();
+
+		_appearanceManager.finish();
+
+		packGeometry( params.sharedBuffers );
+
+		if ( params.spatialIndex ) _spatialIndex = new SpatialIndex( *this );
+	}
+
+	// Pack the polygons data either in the shared buffers or in the arena, so that the teardown does not release it polygon by polygon
+	void CityModel::packGeometry( bool shared )
+	{
+		// Gather the polygons in the objects order, then size the shared buffers once before filling them (the polygons point into them)
+		std::vector< Polygon* > polygons;
+		unsigned int vertexCount = 0, texCoordCount = 0, indexCount = 0;
+
+		CityObjectsMap::const_iterator it = _cityObjectsMap.begin();
+		for ( ; it != _cityObjectsMap.end(); ++it ) 
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+			{
+				const CityObject* obj = it->second[i];
+				for ( unsigned int j = 0; j < obj->size(); j++ )
+				{
+					const Geometry& geom = *obj->getGeometry( j );
+					for ( unsigned int k = 0; k < geom.size(); k++ )
+					{
+						Polygon* p = geom._polygons[k];
+						if ( p->_packedVertices || p->isTesselationPending() ) continue;
+						polygons.push_back( p );
+						vertexCount += p->_vertices.size();
+						if ( !p->_texCoords.empty() ) texCoordCount += p->_vertices.size();
+						indexCount += p->_indices.size();
+					}
+				}
+			}
+
+		if ( shared )
+		{
+			_buffers._vertices.reserve( _buffers._vertices.size() + vertexCount );
+			_buffers._texCoords.reserve( _buffers._texCoords.size() + texCoordCount );
+			_buffers._indices.reserve( _buffers._indices.size() + indexCount );
+		}
+
+		for ( unsigned int i = 0; i < polygons.size(); i++ ) polygons[i]->pack( _arena, shared ? &_buffers : 0 );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	// Key of a render batch: the LOD, the material & texture, and the default color for the polygons without any of them
+	// (which depends on the object class & attributes, and on the geometry type)
+	struct RenderBatchKey
+	{
+		RenderBatchKey( unsigned int lod, const Material* material, const Texture* texture, const TVec4f& color ) 
+			: lod( lod ), material( material ), texture( texture ), color( ( material || texture ) ? TVec4f( 0.f, 0.f, 0.f, 0.f ) : color ) {}
+
+		inline bool operator==( const RenderBatchKey& k ) const 
+		{ 
+			return lod == k.lod && material == k.material && texture == k.texture 
+				&& color.r == k.color.r && color.g == k.color.g && color.b == k.color.b && color.a == k.color.a; 
+		}
+
+		struct Hash
+		{
+			inline size_t operator()( const RenderBatchKey& k ) const
+			{
+				size_t seed = hashCombine( hashCombine( hashCombine( 0, k.lod ), (const void*)k.material ), (const void*)k.texture );
+				for ( unsigned int i = 0; i < 4; i++ ) seed = hashCombine( seed, k.color.rgba[i] );
+				return seed;
+			}
+		};
+
+		unsigned int lod;
+		const Material* material;
+		const Texture* texture;
+		TVec4f color;
+	};
+
+	RenderBatches::RenderBatches( const CityModel& model )
+	{
+		// First gather the polygons of each batch to size the buffers once
+		struct Item { const Polygon* polygon; unsigned int feature; unsigned int batch; };
+		std::vector< Item > items;
+		std::vector< unsigned int > vertexCounts, indexCounts;
+		std::unordered_map< RenderBatchKey, unsigned int, RenderBatchKey::Hash > batches;
+
+		CityObjectsMap::const_iterator it = model.getCityObjectsMap().begin();
+		for ( ; it != model.getCityObjectsMap().end(); ++it ) 
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+			{
+				const CityObject* obj = it->second[i];
+				unsigned int feature = _features.size();
+
+				for ( unsigned int j = 0; j < obj->size(); j++ )
+				{
+					const Geometry& geom = *obj->getGeometry( j );
+					for ( unsigned int k = 0; k < geom.size(); k++ )
+					{
+						const Polygon* p = geom[k];
+						if ( p->getIndices().size() == 0 ) continue;
+
+						RenderBatchKey key( geom.getLOD(), p->getMaterial(), p->getTexture(), obj->getDefaultGeometryColor( geom ) );
+						std::pair< std::unordered_map< RenderBatchKey, unsigned int, RenderBatchKey::Hash >::iterator, bool > b = 
+							batches.insert( std::make_pair( key, (unsigned int)_batches.size() ) );
+						if ( b.second ) 
+						{
+							_batches.push_back( RenderBatch( key.lod, key.material, key.texture, key.color ) );
+							vertexCounts.push_back( 0 );
+							indexCounts.push_back( 0 );
+						}
+
+						Item item = { p, feature, b.first->second };
+						items.push_back( item );
+						vertexCounts[ item.batch ] += p->getVertices().size();
+						indexCounts[ item.batch ] += p->getIndices().size();
+					}
+				}
+
+				if ( !items.empty() && items.back().feature == feature ) _features.push_back( obj );
+			}
+
+		for ( unsigned int i = 0; i < _batches.size(); i++ )
+		{
+			RenderBatch& batch = _batches[i];
+			batch._vertices.reserve( vertexCounts[i] );
+			batch._normals.reserve( vertexCounts[i] );
+			if ( batch._texture ) batch._texCoords.reserve( vertexCounts[i] );
+			batch._featureIds.reserve( vertexCounts[i] );
+			batch._indices.reserve( indexCounts[i] );
+		}
+
+		for ( unsigned int i = 0; i < items.size(); i++ )
+		{
+			const Polygon* p = items[i].polygon;
+			RenderBatch& batch = _batches[ items[i].batch ];
+
+			ArrayView<TVec3d> vertices = p->getVertices();
+			ArrayView<TVec3f> normals = p->getNormals();
+			ArrayView<TVec2f> texCoords = p->getTexCoords();
+			ArrayView<unsigned int> indices = p->getIndices();
+
+			unsigned int offset = batch._vertices.size();
+			batch._vertices.insert( batch._vertices.end(), vertices.begin(), vertices.end() );
+			batch._normals.insert( batch._normals.end(), normals.begin(), normals.end() );
+			if ( batch._texture )
+			{
+				batch._texCoords.insert( batch._texCoords.end(), texCoords.begin(), texCoords.end() );
+				batch._texCoords.resize( batch._vertices.size() );
+			}
+			batch._featureIds.insert( batch._featureIds.end(), vertices.size(), items[i].feature );
+
+			for ( unsigned int k = 0; k < indices.size(); k++ ) batch._indices.push_back( offset + indices[k] );
+		}
+	}
+}
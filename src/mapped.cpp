@@ -0,0 +1,400 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "citygml.h"
+#include "binaryformat.h"
+#include <string.h>
+
+#ifdef WIN32
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace citygml
+{
+	using namespace binary;
+
+	static Envelope makeEnvelope( const double* e )
+	{
+		return Envelope( TVec3d( e[0], e[1], e[2] ), TVec3d( e[3], e[4], e[5] ) );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	const char* MappedObject::getId( void ) const
+	{
+		return _model ? _model->getString( _id ) : "";
+	}
+
+	unsigned int MappedObject::getAttributesCount( void ) const
+	{
+		return ( _model && checkRange( _attributesFirst, _attributesCount, _model->_attributes.count ) ) ? _attributesCount : 0;
+	}
+
+	const char* MappedObject::getAttributeName( unsigned int i ) const
+	{
+		const AttributeRecord* r = ( i < getAttributesCount() ) ? _model->_attributes.at( _attributesFirst + i ) : 0;
+		return r ? _model->getString( r->name ) : "";
+	}
+
+	AttributeValue MappedObject::getAttributeValue( unsigned int i ) const
+	{
+		const AttributeRecord* r = ( i < getAttributesCount() ) ? _model->_attributes.at( _attributesFirst + i ) : 0;
+		return r ? ModelSerializer::makeValue( _model->getString( r->text ), r->type, r->value ) : AttributeValue();
+	}
+
+	const char* MappedObject::getAttribute( const std::string& name, const char* defvalue ) const
+	{
+		for ( unsigned int i = 0; i < getAttributesCount(); i++ )
+		{
+			const AttributeRecord* r = _model->_attributes.at( _attributesFirst + i );
+			if ( r && name == _model->getString( r->name ) ) return _model->getString( r->text );
+		}
+		return defvalue;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedAppearance::MappedAppearance( const MappedCityModel* model, unsigned int index )
+		: MappedObject( 0, 0, 0, 0 ), _record( model ? model->_appearances.at( index ) : 0 )
+	{
+		if ( !_record ) return;
+		_model = model;
+		_id = _record->id;
+		_attributesFirst = _record->attributesFirst;
+		_attributesCount = _record->attributesCount;
+	}
+
+	const char* MappedAppearance::getType( void ) const
+	{
+		if ( !_record ) return "";
+		switch ( _record->kind )
+		{
+		case AK_Material: return "Material";
+		case AK_Texture: return "Texture";
+		case AK_GeoreferencedTexture: return "GeoreferencedTexture";
+		default: return "";
+		}
+	}
+
+	bool MappedAppearance::isMaterial( void ) const { return _record && _record->kind == AK_Material; }
+
+	bool MappedAppearance::isTexture( void ) const { return _record && ( _record->kind == AK_Texture || _record->kind == AK_GeoreferencedTexture ); }
+
+	bool MappedAppearance::getIsFront( void ) const { return !_record || _record->isFront != 0; }
+
+	TVec3f MappedAppearance::getDiffuse( void ) const { return _record ? TVec3f( _record->diffuse[0], _record->diffuse[1], _record->diffuse[2] ) : TVec3f(); }
+
+	TVec3f MappedAppearance::getEmissive( void ) const { return _record ? TVec3f( _record->emissive[0], _record->emissive[1], _record->emissive[2] ) : TVec3f(); }
+
+	TVec3f MappedAppearance::getSpecular( void ) const { return _record ? TVec3f( _record->specular[0], _record->specular[1], _record->specular[2] ) : TVec3f(); }
+
+	float MappedAppearance::getAmbientIntensity( void ) const { return _record ? _record->ambientIntensity : 0.f; }
+
+	float MappedAppearance::getShininess( void ) const { return _record ? _record->shininess : 0.f; }
+
+	float MappedAppearance::getTransparency( void ) const { return _record ? _record->transparency : 0.f; }
+
+	const char* MappedAppearance::getUrl( void ) const { return _record ? _model->getString( _record->url ) : ""; }
+
+	bool MappedAppearance::getRepeat( void ) const { return _record && _record->repeat != 0; }
+
+	Texture::WrapMode MappedAppearance::getWrapMode( void ) const
+	{
+		return ( _record && _record->wrapMode <= Texture::WM_BORDER ) ? (Texture::WrapMode)_record->wrapMode : Texture::WM_NONE;
+	}
+
+	TVec4f MappedAppearance::getBorderColor( void ) const
+	{
+		return _record ? TVec4f( _record->borderColor[0], _record->borderColor[1], _record->borderColor[2], _record->borderColor[3] ) : TVec4f();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedPolygon::MappedPolygon( const MappedCityModel* model, unsigned int index )
+		: MappedObject( 0, 0, 0, 0 ), _record( model ? model->_polygons.at( index ) : 0 )
+	{
+		if ( !_record ) return;
+		_model = model;
+		_id = _record->id;
+		_attributesFirst = _record->attributesFirst;
+		_attributesCount = _record->attributesCount;
+	}
+
+	ArrayView<TVec3d> MappedPolygon::getVertices( void ) const
+	{
+		if ( !_record || !checkRange( _record->vertexOffset, _record->vertexCount, _model->_vertices.count ) ) return ArrayView<TVec3d>();
+		return ArrayView<TVec3d>( _model->_vertices.data + _record->vertexOffset, _record->vertexCount );
+	}
+
+	ArrayView<unsigned int> MappedPolygon::getIndices( void ) const
+	{
+		if ( !_record || !checkRange( _record->indexOffset, _record->indexCount, _model->_indices.count ) ) return ArrayView<unsigned int>();
+		// Each access checks the indices against the vertices actually returned
+		const unsigned int* indices = _model->_indices.data + _record->indexOffset;
+		unsigned int count = getVertices().size();
+		for ( unsigned int k = 0; k < _record->indexCount; k++ ) if ( indices[k] >= count ) return ArrayView<unsigned int>();
+		return ArrayView<unsigned int>( indices, _record->indexCount );
+	}
+
+	ArrayView<TVec3f> MappedPolygon::getNormals( void ) const
+	{
+		unsigned int count = getVertices().size();
+		if ( !_record || _record->normalsOffset == NONE ) return ArrayView<TVec3f>( (const TVec3f*)( _record ? _record->normal : 0 ), count, 0 );
+		if ( !checkRange( _record->normalsOffset, count, _model->_normals.count ) ) return ArrayView<TVec3f>();
+		return ArrayView<TVec3f>( _model->_normals.data + _record->normalsOffset, count );
+	}
+
+	ArrayView<TVec2f> MappedPolygon::getTexCoords( void ) const
+	{
+		if ( !_record || _record->texCoordsOffset == NONE || !checkRange( _record->texCoordsOffset, _record->vertexCount, _model->_texCoords.count ) ) return ArrayView<TVec2f>();
+		return ArrayView<TVec2f>( _model->_texCoords.data + _record->texCoordsOffset, _record->vertexCount );
+	}
+
+	bool MappedPolygon::hasUniformNormal( void ) const { return !_record || _record->normalsOffset == NONE; }
+
+	TVec3f MappedPolygon::getNormal( void ) const { return _record ? TVec3f( _record->normal[0], _record->normal[1], _record->normal[2] ) : TVec3f(); }
+
+	MappedAppearance MappedPolygon::getAppearance( void ) const { return _record ? MappedAppearance( _model, _record->appearance ) : MappedAppearance(); }
+
+	MappedAppearance MappedPolygon::getMaterial( void ) const
+	{
+		MappedAppearance front = getMaterialFront();
+		return front.isValid() ? front : getMaterialBack();
+	}
+
+	MappedAppearance MappedPolygon::getMaterialFront( void ) const { return _record ? MappedAppearance( _model, _record->materialFront ) : MappedAppearance(); }
+
+	MappedAppearance MappedPolygon::getMaterialBack( void ) const { return _record ? MappedAppearance( _model, _record->materialBack ) : MappedAppearance(); }
+
+	MappedAppearance MappedPolygon::getTexture( void ) const { return _record ? MappedAppearance( _model, _record->texture ) : MappedAppearance(); }
+
+	unsigned int MappedPolygon::getSourcesCount( void ) const
+	{
+		return ( _record && checkRange( _record->sourcesFirst, _record->sourcesCount, _model->_sources.count ) ) ? _record->sourcesCount : 0;
+	}
+
+	PolygonRange MappedPolygon::getSource( unsigned int i ) const
+	{
+		const SourceRecord* s = ( i < getSourcesCount() ) ? _model->_sources.at( _record->sourcesFirst + i ) : 0;
+		if ( s && ( !checkRange( s->vertexOffset, s->vertexCount, _record->vertexCount ) || !checkRange( s->indexOffset, s->indexCount, _record->indexCount ) ) ) s = 0;
+		return s ? PolygonRange( _model->getString( s->id ), s->vertexOffset, s->vertexCount, s->indexOffset, s->indexCount ) : PolygonRange( "", 0, 0, 0, 0 );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedGeometry::MappedGeometry( const MappedCityModel* model, unsigned int index )
+		: MappedObject( 0, 0, 0, 0 ), _record( model ? model->_geometries.at( index ) : 0 )
+	{
+		if ( !_record ) return;
+		_model = model;
+		_id = _record->id;
+		_attributesFirst = _record->attributesFirst;
+		_attributesCount = _record->attributesCount;
+	}
+
+	GeometryType MappedGeometry::getType( void ) const { return ( _record && _record->type <= GT_Ceiling ) ? (GeometryType)_record->type : GT_Unknown; }
+
+	unsigned int MappedGeometry::getLOD( void ) const { return _record ? _record->lod : 0; }
+
+	unsigned int MappedGeometry::size( void ) const
+	{
+		return ( _record && checkRange( _record->polygonsFirst, _record->polygonsCount, _model->_polygons.count ) ) ? _record->polygonsCount : 0;
+	}
+
+	MappedPolygon MappedGeometry::operator[]( unsigned int i ) const
+	{
+		return ( i < size() ) ? MappedPolygon( _model, _record->polygonsFirst + i ) : MappedPolygon();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedCityObject::MappedCityObject( const MappedCityModel* model, unsigned int index )
+		: MappedObject( 0, 0, 0, 0 ), _record( model ? model->_objects.at( index ) : 0 )
+	{
+		if ( !_record ) return;
+		_model = model;
+		_id = _record->id;
+		_attributesFirst = _record->attributesFirst;
+		_attributesCount = _record->attributesCount;
+	}
+
+	CityObjectsType MappedCityObject::getType( void ) const { return _record ? (CityObjectsType)_record->type : COT_GenericCityObject; }
+
+	Envelope MappedCityObject::getEnvelope( void ) const { return _record ? makeEnvelope( _record->envelope ) : Envelope(); }
+
+	unsigned int MappedCityObject::size( void ) const
+	{
+		return ( _record && checkRange( _record->geometriesFirst, _record->geometriesCount, _model->_geometries.count ) ) ? _record->geometriesCount : 0;
+	}
+
+	MappedGeometry MappedCityObject::getGeometry( unsigned int i ) const
+	{
+		return ( i < size() ) ? MappedGeometry( _model, _record->geometriesFirst + i ) : MappedGeometry();
+	}
+
+	unsigned int MappedCityObject::getChildCount( void ) const
+	{
+		return ( _record && checkRange( _record->childrenFirst, _record->childrenCount, _model->_children.count ) ) ? _record->childrenCount : 0;
+	}
+
+	MappedCityObject MappedCityObject::getChild( unsigned int i ) const
+	{
+		// Rejects the children which would make the hierarchy other than a forest, so that walking it always ends
+		uint32_t index = _record ? _record - _model->_objects.data : 0;
+		if ( i >= getChildCount() || !checkListed( _model->_objects.data, _model->_objects.count, index, _model->_children.data + _record->childrenFirst, i ) ) return MappedCityObject();
+		return MappedCityObject( _model, _model->_children.data[ _record->childrenFirst + i ] );
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedCityModel::MappedCityModel( void ) : MappedObject( 0, 0, 0, 0 ), _data( 0 ), _size( 0 ), _chars( 0 ), _charsSize( 0 ), _record( 0 ) {}
+
+	MappedCityModel::~MappedCityModel( void )
+	{
+		if ( !_data ) return;
+#ifdef WIN32
+		UnmapViewOfFile( _data );
+#else
+		munmap( _data, _size );
+#endif
+	}
+
+	bool MappedCityModel::open( const std::string& fileName )
+	{
+#ifdef WIN32
+		HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+		if ( file == INVALID_HANDLE_VALUE ) return false;
+
+		LARGE_INTEGER size;
+		HANDLE mapping = ( GetFileSizeEx( file, &size ) && size.QuadPart > 0 ) ? CreateFileMappingA( file, 0, PAGE_READONLY, 0, 0, 0 ) : 0;
+		if ( mapping )
+		{
+			_data = (char*)MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+			_size = (size_t)size.QuadPart;
+			CloseHandle( mapping );
+		}
+		CloseHandle( file );
+#else
+		int fd = ::open( fileName.c_str(), O_RDONLY );
+		if ( fd < 0 ) return false;
+
+		struct stat st;
+		if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+		{
+			void* data = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+			if ( data != MAP_FAILED )
+			{
+				_data = (char*)data;
+				_size = st.st_size;
+			}
+		}
+		close( fd );
+#endif
+		if ( !_data ) return false;
+
+		// Only the header & the blocks directory are checked, the records are checked when accessed
+		const FileHeader* header = (const FileHeader*)_data;
+		const BlockEntry* blocks[ BT_Count ];
+		if ( !checkHeader( *header, _size ) || !findBlocks( (const BlockEntry*)( _data + sizeof( FileHeader ) ), header->blocksCount, _size, blocks ) ) return false;
+
+		_stringsOffsets.data = (const unsigned long long*)( _data + blocks[ BT_Strings ]->offset );
+		_stringsOffsets.count = blocks[ BT_Strings ]->count + 1;
+		_chars = (const char*)( _stringsOffsets.data + _stringsOffsets.count );
+		_charsSize = blocks[ BT_Strings ]->size - _stringsOffsets.count * sizeof( uint64_t );
+
+		_record = (const ModelRecord*)( _data + blocks[ BT_Model ]->offset );
+
+#define MAP_BLOCK( _block_, _type_, _blockType_ ) \
+		_block_.data = (const _type_*)( _data + blocks[ _blockType_ ]->offset ); \
+		_block_.count = blocks[ _blockType_ ]->count
+
+		MAP_BLOCK( _attributes, AttributeRecord, BT_Attributes );
+		MAP_BLOCK( _appearances, AppearanceRecord, BT_Appearances );
+		MAP_BLOCK( _objects, ObjectRecord, BT_Objects );
+		MAP_BLOCK( _children, unsigned int, BT_Children );
+		MAP_BLOCK( _roots, unsigned int, BT_Roots );
+		MAP_BLOCK( _geometries, GeometryRecord, BT_Geometries );
+		MAP_BLOCK( _polygons, PolygonRecord, BT_Polygons );
+		MAP_BLOCK( _sources, SourceRecord, BT_Sources );
+		MAP_BLOCK( _vertices, TVec3d, BT_Vertices );
+		MAP_BLOCK( _texCoords, TVec2f, BT_TexCoords );
+		MAP_BLOCK( _indices, unsigned int, BT_Indices );
+		MAP_BLOCK( _normals, TVec3f, BT_Normals );
+#undef MAP_BLOCK
+
+		_model = this;
+		_id = _record->id;
+		_attributesFirst = _record->attributesFirst;
+		_attributesCount = _record->attributesCount;
+		return true;
+	}
+
+	const char* MappedCityModel::getString( unsigned int i ) const
+	{
+		if ( i + 1ULL >= _stringsOffsets.count ) return "";
+		unsigned long long begin = _stringsOffsets.data[i], end = _stringsOffsets.data[ i + 1 ];
+		return ( begin < end && end <= _charsSize && _chars[ end - 1 ] == 0 ) ? _chars + begin : "";
+	}
+
+	Envelope MappedCityModel::getEnvelope( void ) const { return makeEnvelope( _record->envelope ); }
+
+	TVec3d MappedCityModel::getTranslationParameters( void ) const { return TVec3d( _record->translation[0], _record->translation[1], _record->translation[2] ); }
+
+	const char* MappedCityModel::getSRSName( void ) const { return getString( _record->srsName ); }
+
+	std::vector< MappedCityObject > MappedCityModel::getCityObjectsByType( CityObjectsTypeMask mask ) const
+	{
+		std::vector< MappedCityObject > objects;
+		for ( unsigned int i = 0; i < _objects.count; i++ )
+			if ( _objects.data[i].type & mask ) objects.push_back( MappedCityObject( this, i ) );
+		return objects;
+	}
+
+	MappedCityObject MappedCityModel::getRoot( unsigned int i ) const
+	{
+		return ( i < _roots.count && checkListed( _objects.data, _objects.count, NONE, _roots.data, i ) ) ? MappedCityObject( this, _roots.data[i] ) : MappedCityObject();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	MappedCityModel* ModelSerializer::map( const std::string& fileName )
+	{
+		if ( !isLittleEndianHost() )
+		{
+			std::cerr << "CityGML: Binary models are only supported on little-endian hosts!" << std::endl;
+			return 0;
+		}
+
+		MappedCityModel* model = new MappedCityModel();
+		if ( !model->open( fileName ) )
+		{
+			std::cerr << "CityGML: Unable to map binary model " << fileName << std::endl;
+			delete model;
+			return 0;
+		}
+		return model;
+	}
+
+	MappedCityModel* map_binary( const std::string& fileName )
+	{
+		return ModelSerializer::map( fileName );
+	}
+}
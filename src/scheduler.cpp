@@ -0,0 +1,152 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "scheduler.h"
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+
+struct Scheduler::Worker
+{
+	std::mutex lock;
+	std::deque< unsigned int > tasks;
+	size_t load;
+};
+
+Scheduler::Scheduler( unsigned int workersCount ) : _workersCount( workersCount )
+{
+	if ( _workersCount == 0 ) _workersCount = std::thread::hardware_concurrency();
+	if ( _workersCount == 0 ) _workersCount = 1;
+	_stats.resize( _workersCount );
+}
+
+void Scheduler::add( const Task& task, size_t cost )
+{
+	Entry e;
+	e.task = task;
+	e.cost = cost;
+	_tasks.push_back( e );
+}
+
+static bool isMoreCostly( const std::pair< size_t, unsigned int >& a, const std::pair< size_t, unsigned int >& b ) 
+{ 
+	return a.first > b.first; 
+}
+
+void Scheduler::run( void )
+{
+	unsigned int count = _tasks.size();
+	unsigned int workersCount = std::min( count, _workersCount );
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if ( workersCount <= 1 )
+	{
+		for ( unsigned int i = 0; i < count; i++ ) 
+		{
+			_tasks[i].task( 0 );
+			_stats[0].cost += _tasks[i].cost;
+		}
+		_stats[0].tasks += count;
+		_stats[0].busyTime += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	}
+	else
+		runParallel( workersCount );
+
+	double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	for ( unsigned int i = 0; i < _workersCount; i++ ) _stats[i].elapsedTime += elapsed;
+
+	_tasks.clear();
+}
+
+void Scheduler::runParallel( unsigned int workersCount )
+{
+	unsigned int count = _tasks.size();
+
+	// Longest tasks first, each one queued to the least loaded worker
+	std::vector< std::pair< size_t, unsigned int > > order( count );
+	for ( unsigned int i = 0; i < count; i++ ) order[i] = std::make_pair( _tasks[i].cost, i );
+	std::stable_sort( order.begin(), order.end(), isMoreCostly );
+
+	std::vector< Worker* > workers( workersCount );
+	for ( unsigned int i = 0; i < workersCount; i++ ) { workers[i] = new Worker(); workers[i]->load = 0; }
+
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		Worker* w = workers[0];
+		for ( unsigned int j = 1; j < workersCount; j++ ) if ( workers[j]->load < w->load ) w = workers[j];
+		w->tasks.push_back( order[i].second );
+		w->load += order[i].first;
+	}
+
+	std::vector< std::thread > threads;
+	threads.reserve( workersCount - 1 );
+	for ( unsigned int i = 1; i < workersCount; i++ )
+		threads.push_back( std::thread( &Scheduler::runWorker, this, std::ref( workers ), i ) );
+
+	runWorker( workers, 0 );
+
+	for ( unsigned int i = 0; i < threads.size(); i++ ) threads[i].join();
+
+	for ( unsigned int i = 0; i < workersCount; i++ ) delete workers[i];
+}
+
+void Scheduler::runWorker( std::vector< Worker* >& workers, unsigned int id )
+{
+	citygml::WorkerStats& stats = _stats[id];
+	unsigned int count = workers.size();
+
+	for ( ;; )
+	{
+		unsigned int task = 0;
+		bool found = false, stolen = false;
+
+		// Own tasks are taken from the front (most costly first)...
+		{
+			std::lock_guard< std::mutex > lock( workers[id]->lock );
+			if ( !workers[id]->tasks.empty() ) 
+			{
+				task = workers[id]->tasks.front();
+				workers[id]->tasks.pop_front();
+				found = true;
+			}
+		}
+
+		// ... while the other ones are stolen from the back
+		for ( unsigned int i = 1; !found && i < count; i++ )
+		{
+			Worker* victim = workers[ ( id + i ) % count ];
+			std::lock_guard< std::mutex > lock( victim->lock );
+			if ( victim->tasks.empty() ) continue;
+			task = victim->tasks.back();
+			victim->tasks.pop_back();
+			found = stolen = true;
+		}
+
+		// No task is added while running, so there is nothing left to do
+		if ( !found ) return;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		_tasks[task].task( id );
+		stats.busyTime += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+		stats.tasks++;
+		stats.cost += _tasks[task].cost;
+		if ( stolen ) stats.stolenTasks++;
+	}
+}
@@ -0,0 +1,67 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include "citygml.h"
+#include <functional>
+#include <vector>
+
+// Work-stealing task scheduler.
+// Queued tasks are spread among the workers by decreasing cost (each one going to the least loaded worker), 
+// then idle workers steal the cheapest remaining tasks of the others. The calling thread is worker 0.
+class Scheduler 
+{
+public:
+	// Task functor, called with the index of the worker running it
+	typedef std::function< void ( unsigned int worker ) > Task;
+
+	// A null workers count means one worker per hardware thread
+	Scheduler( unsigned int workersCount = 0 );
+
+	inline unsigned int getWorkersCount( void ) const { return _workersCount; }
+
+	// Queue a task with its estimated cost (eg. a number of vertices)
+	void add( const Task& task, size_t cost = 1 );
+
+	// Run the queued tasks and return once they are all done
+	void run( void );
+
+	// Statistics of each worker, accumulated over the runs
+	inline const std::vector< citygml::WorkerStats >& getStats( void ) const { return _stats; }
+
+private:
+	struct Entry
+	{
+		Task task;
+		size_t cost;
+	};
+
+	struct Worker;
+
+	void runParallel( unsigned int workersCount );
+	void runWorker( std::vector< Worker* >& workers, unsigned int id );
+
+private:
+	unsigned int _workersCount;
+
+	std::vector< Entry > _tasks;
+
+	std::vector< citygml::WorkerStats > _stats;
+};
+
+#endif // __SCHEDULER_H__
@@ -0,0 +1,264 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "citygml.h"
+#include <queue>
+#include <cmath>
+
+namespace citygml
+{
+	// Maximal number of entries of a node
+	static const unsigned int NODE_CAPACITY = 16;
+
+	static inline bool isEmpty( const Envelope& e )
+	{
+		const TVec3d& l = e.getLowerBound();
+		const TVec3d& u = e.getUpperBound();
+		return ( l.x == 0. && l.y == 0. && l.z == 0. && u.x == 0. && u.y == 0. && u.z == 0. ) || l.x > u.x || l.y > u.y || l.z > u.z;
+	}
+
+	static inline void extend( TVec3d& lower, TVec3d& upper, const TVec3d& p )
+	{
+		for ( unsigned int i = 0; i < 3; i++ )
+		{
+			lower[i] = std::min( lower[i], p[i] );
+			upper[i] = std::max( upper[i], p[i] );
+		}
+	}
+
+	static inline bool intersects( const TVec3d& lower, const TVec3d& upper, const Envelope& box )
+	{
+		const TVec3d& l = box.getLowerBound();
+		const TVec3d& u = box.getUpperBound();
+		return lower.x <= u.x && l.x <= upper.x && lower.y <= u.y && l.y <= upper.y && lower.z <= u.z && l.z <= upper.z;
+	}
+
+	// Squared distance from a point to a box, null inside
+	static inline double distance2( const TVec3d& lower, const TVec3d& upper, const TVec3d& p )
+	{
+		double d = 0.;
+		for ( unsigned int i = 0; i < 3; i++ )
+		{
+			double delta = std::max( std::max( lower[i] - p[i], p[i] - upper[i] ), 0. );
+			d += delta * delta;
+		}
+		return d;
+	}
+
+	// The envelope of an object, or else the bounding box of its polygons & children, which leaves the lazy tesselation pending
+	static bool getObjectBounds( const CityObject* obj, std::unordered_map< const CityObject*, Envelope >& bounds, Envelope& result )
+	{
+		if ( !isEmpty( obj->getEnvelope() ) ) { result = obj->getEnvelope(); return true; }
+
+		std::unordered_map< const CityObject*, Envelope >::const_iterator it = bounds.find( obj );
+		if ( it != bounds.end() ) { result = it->second; return !isEmpty( result ); }
+		bounds[ obj ] = Envelope();	// guards against cycles
+
+		double inf = std::numeric_limits< double >::infinity();
+		TVec3d lower( inf, inf, inf ), upper( -inf, -inf, -inf );
+		for ( unsigned int i = 0; i < obj->size(); i++ )
+		{
+			const Geometry& geom = *obj->getGeometry( i );
+			for ( unsigned int j = 0; j < geom.size(); j++ ) geom[j]->extendBounds( lower, upper );
+		}
+
+		Envelope child;
+		for ( unsigned int i = 0; i < obj->getChildCount(); i++ )
+			if ( getObjectBounds( obj->getChild( i ), bounds, child ) )
+			{
+				extend( lower, upper, child.getLowerBound() );
+				extend( lower, upper, child.getUpperBound() );
+			}
+
+		if ( lower.x > upper.x ) return false;
+		result = bounds[ obj ] = Envelope( lower, upper );
+		return true;
+	}
+
+	// Sort the entries in Sort-Tile-Recursive order: vertical slices by center x, then by center y in each slice,
+	// so that each run of NODE_CAPACITY entries makes a compact node
+	class STROrder
+	{
+	public:
+		STROrder( const std::vector< TVec3d >& centers, unsigned int axis ) : _centers( centers ), _axis( axis ) {}
+
+		inline bool operator()( unsigned int a, unsigned int b ) const { return _centers[a][_axis] < _centers[b][_axis]; }
+
+		static void sort( const std::vector< TVec3d >& centers, std::vector< unsigned int >& order )
+		{
+			order.resize( centers.size() );
+			for ( unsigned int i = 0; i < order.size(); i++ ) order[i] = i;
+
+			unsigned int nodes = ( order.size() + NODE_CAPACITY - 1 ) / NODE_CAPACITY;
+			unsigned int slices = (unsigned int)ceil( sqrt( (double)nodes ) );
+			unsigned int sliceSize = slices * NODE_CAPACITY;
+
+			std::sort( order.begin(), order.end(), STROrder( centers, 0 ) );
+			for ( unsigned int first = 0; first < order.size(); first += sliceSize )
+				std::sort( order.begin() + first, order.begin() + std::min( first + sliceSize, (unsigned int)order.size() ), STROrder( centers, 1 ) );
+		}
+
+	private:
+		const std::vector< TVec3d >& _centers;
+		unsigned int _axis;
+	};
+
+	SpatialIndex::SpatialIndex( const CityModel& model ) : _leavesCount( 0 )
+	{
+		// Gather the objects with their bounds
+		std::vector< const CityObject* > objects;
+		std::vector< Envelope > envelopes;
+		std::vector< TVec3d > centers;
+		std::unordered_map< const CityObject*, Envelope > bounds;
+
+		CityObjectsMap::const_iterator it = model.getCityObjectsMap().begin();
+		for ( ; it != model.getCityObjectsMap().end(); ++it )
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+			{
+				Envelope e;
+				if ( !getObjectBounds( it->second[i], bounds, e ) ) continue;
+				objects.push_back( it->second[i] );
+				envelopes.push_back( e );
+				centers.push_back( ( e.getLowerBound() + e.getUpperBound() ) * 0.5 );
+			}
+
+		if ( objects.empty() ) return;
+
+		// Pack the leaves
+		std::vector< unsigned int > order;
+		STROrder::sort( centers, order );
+
+		_objects.reserve( objects.size() );
+		_envelopes.reserve( objects.size() );
+		for ( unsigned int i = 0; i < order.size(); i++ )
+		{
+			_objects.push_back( objects[ order[i] ] );
+			_envelopes.push_back( envelopes[ order[i] ] );
+		}
+
+		for ( unsigned int first = 0; first < _objects.size(); first += NODE_CAPACITY )
+		{
+			double inf = std::numeric_limits< double >::infinity();
+			Node node;
+			node.lower = TVec3d( inf, inf, inf );
+			node.upper = TVec3d( -inf, -inf, -inf );
+			node.types = 0;
+			node.first = first;
+			node.count = std::min( NODE_CAPACITY, (unsigned int)_objects.size() - first );
+			for ( unsigned int i = first; i < first + node.count; i++ )
+			{
+				extend( node.lower, node.upper, _envelopes[i].getLowerBound() );
+				extend( node.lower, node.upper, _envelopes[i].getUpperBound() );
+				node.types |= _objects[i]->getType();
+			}
+			_nodes.push_back( node );
+		}
+		_leavesCount = _nodes.size();
+
+		// Then pack each level into the next one until a single root is left
+		unsigned int levelFirst = 0;
+		while ( _nodes.size() - levelFirst > 1 )
+		{
+			unsigned int levelSize = _nodes.size() - levelFirst;
+
+			// Reordering the level is fine since no node refers to it yet, while the levels below are referred to by range
+			std::vector< TVec3d > nodeCenters( levelSize );
+			for ( unsigned int i = 0; i < levelSize; i++ ) nodeCenters[i] = ( _nodes[ levelFirst + i ].lower + _nodes[ levelFirst + i ].upper ) * 0.5;
+			STROrder::sort( nodeCenters, order );
+
+			std::vector< Node > level( levelSize );
+			for ( unsigned int i = 0; i < levelSize; i++ ) level[i] = _nodes[ levelFirst + order[i] ];
+			std::copy( level.begin(), level.end(), _nodes.begin() + levelFirst );
+
+			for ( unsigned int first = 0; first < levelSize; first += NODE_CAPACITY )
+			{
+				Node node = level[ first ];
+				node.first = levelFirst + first;
+				node.count = std::min( NODE_CAPACITY, levelSize - first );
+				for ( unsigned int i = first + 1; i < first + node.count; i++ )
+				{
+					extend( node.lower, node.upper, level[i].lower );
+					extend( node.lower, node.upper, level[i].upper );
+					node.types |= level[i].types;
+				}
+				_nodes.push_back( node );
+			}
+
+			levelFirst += levelSize;
+		}
+	}
+
+	void SpatialIndex::intersect( const Envelope& box, std::vector< const CityObject* >& result, CityObjectsTypeMask mask ) const
+	{
+		if ( _nodes.empty() ) return;
+
+		std::vector< unsigned int > stack( 1, _nodes.size() - 1 );
+		while ( !stack.empty() )
+		{
+			const Node& node = _nodes[ stack.back() ];
+			bool leaf = isLeaf( stack.back() );
+			stack.pop_back();
+			if ( !( node.types & mask ) || !intersects( node.lower, node.upper, box ) ) continue;
+
+			for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+			{
+				if ( !leaf ) stack.push_back( i );
+				else if ( ( _objects[i]->getType() & mask ) && intersects( _envelopes[i].getLowerBound(), _envelopes[i].getUpperBound(), box ) ) result.push_back( _objects[i] );
+			}
+		}
+	}
+
+	void SpatialIndex::contain( const TVec3d& point, std::vector< const CityObject* >& result, CityObjectsTypeMask mask ) const
+	{
+		intersect( Envelope( point, point ), result, mask );
+	}
+
+	void SpatialIndex::nearest( const TVec3d& point, unsigned int k, std::vector< const CityObject* >& result, CityObjectsTypeMask mask ) const
+	{
+		if ( _nodes.empty() || k == 0 ) return;
+
+		// Best first search: the closest entry is expanded first, so the objects come out by increasing distance.
+		// The objects are pushed with an index offset by the nodes count.
+		typedef std::pair< double, unsigned int > Entry;
+		std::priority_queue< Entry, std::vector< Entry >, std::greater< Entry > > queue;
+		unsigned int nodesCount = _nodes.size();
+		queue.push( Entry( 0., nodesCount - 1 ) );
+
+		unsigned int found = 0;
+		while ( !queue.empty() && found < k )
+		{
+			unsigned int index = queue.top().second;
+			queue.pop();
+
+			if ( index >= nodesCount )
+			{
+				result.push_back( _objects[ index - nodesCount ] );
+				found++;
+				continue;
+			}
+
+			const Node& node = _nodes[ index ];
+			for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+			{
+				if ( isLeaf( index ) )
+				{
+					if ( _objects[i]->getType() & mask ) queue.push( Entry( distance2( _envelopes[i].getLowerBound(), _envelopes[i].getUpperBound(), point ), nodesCount + i ) );
+				}
+				else if ( _nodes[i].types & mask ) queue.push( Entry( distance2( _nodes[i].lower, _nodes[i].upper, point ), i ) );
+			}
+		}
+	}
+}
@@ -1,138 +1,585 @@
-/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
-*
-* Contributors:
-*  - Manuel Garnier, BRGM - better normal computation
-*
-* This file is part of libcitygml library
-* http://code.google.com/p/libcitygml
-*
-* libcitygml is free software: you can redistribute it and/or modify
-* it under the terms of the GNU Lesser General Public License as published by
-* the Free Software Foundation, either version 2.1 of the License, or
-* (at your option) any later version.
-*
-* libcitygml is distributed in the hope that it will be useful,
-* but WITHOUT ANY WARRANTY; without even the implied warranty of
-* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-* GNU Lesser General Public License for more details.
-*/
-
-#include "tesselator.h"
-#ifndef WIN32
-#	include <stdint.h>
-#endif
-
-Tesselator::Tesselator( void )
-{
-	_tobj = gluNewTess(); 
-
-	gluTessCallback( _tobj, GLU_TESS_VERTEX_DATA, (GLU_TESS_CALLBACK)&vertexCallback );
-	gluTessCallback( _tobj, GLU_TESS_BEGIN_DATA, (GLU_TESS_CALLBACK)&beginCallback );
-	gluTessCallback( _tobj, GLU_TESS_END_DATA, (GLU_TESS_CALLBACK)&endCallback );
-	gluTessCallback( _tobj, GLU_TESS_COMBINE_DATA, (GLU_TESS_CALLBACK)&combineCallback );
-	gluTessCallback( _tobj, GLU_TESS_ERROR_DATA, (GLU_TESS_CALLBACK)&errorCallback );
-}
-
-void Tesselator::init( unsigned int verticesCount, const TVec3d& normal, GLenum winding_rule )
-{
-	gluTessBeginPolygon( _tobj, this ); 
-
-	gluTessProperty( _tobj, GLU_TESS_WINDING_RULE, winding_rule );
-	gluTessNormal( _tobj, normal.x, normal.y, normal.z );
-
-	_vertices.clear();
-	_vertices.reserve( verticesCount );
-	_indices.clear();
-	_curIndices.clear();
-}
-
-Tesselator::~Tesselator( void ) 
-{
-	gluDeleteTess( _tobj );
-}
-
-void Tesselator::compute( void ) 
-{
-	gluTessEndPolygon( _tobj );  
-}
-
-void Tesselator::addContour( const std::vector<TVec3d>& pts, const std::vector<TVec2f>& tex )
-{		
-	unsigned int len = pts.size();
-	if ( len < 3 ) return;
-
-	unsigned int pos = _vertices.size();
-
-	gluTessBeginContour( _tobj );
-
-	for ( unsigned int i = 0; i < len; i++ ) 
-	{
-		_vertices.push_back( pts[i] );
-
-		gluTessVertex( _tobj, &(_vertices[pos+i][0]), (void*)(pos+i) );
-	}
-
-	gluTessEndContour( _tobj );
-}
-
-void CALLBACK Tesselator::beginCallback( GLenum which, void* userData ) 
-{
-	Tesselator *tess = (Tesselator*)userData;
-	tess->_curMode = which;
-}
-
-void CALLBACK Tesselator::vertexCallback( GLvoid *data, void* userData ) 
-{
-	Tesselator *tess = (Tesselator*)userData;
-	tess->_curIndices.push_back( (intptr_t)data );
-}
-
-void CALLBACK Tesselator::combineCallback( GLdouble coords[3], void* vertex_data[4], GLfloat weight[4], void** outData, void* userData )
-{
-	Tesselator *tess = (Tesselator*)userData;
-	unsigned int npoint = tess->_vertices.size();
-	tess->_vertices.push_back( TVec3d( coords[0], coords[1], coords[2] ) );
-
-	*outData = (void*)npoint;
-}
-
-void CALLBACK Tesselator::endCallback( void* userData ) 
-{
-	Tesselator *tess = (Tesselator*)userData;
-
-	unsigned int len = tess->_curIndices.size();
-
-	switch ( tess->_curMode ) 
-	{
-	case GL_TRIANGLES:
-		for ( unsigned int i = 0; i < len; i++ ) tess->_indices.push_back( tess->_curIndices[i] );
-		break;
-	case GL_TRIANGLE_FAN:
-	case GL_TRIANGLE_STRIP: 
-		{
-			unsigned int first = tess->_curIndices[0];
-			unsigned int prev = tess->_curIndices[1];
-
-			for ( unsigned int i = 2; i < len; i++ ) 
-			{
-				if ( tess->_curMode == GL_TRIANGLE_FAN || i%2 == 0 ) tess->_indices.push_back( first );
-				tess->_indices.push_back( prev );
-				if ( tess->_curMode == GL_TRIANGLE_STRIP )
-				{
-					if ( i%2 == 1) tess->_indices.push_back( first );
-					first = prev;
-				}
-				prev = tess->_curIndices[i];
-				tess->_indices.push_back( prev );
-			}
-		}
-		break;
-	default: std::cerr << "CityGML tesselator: non-supported GLU tesselator primitive " << tess->_curMode << std::endl;
-	}
-	tess->_curIndices.clear();
-}
-
-void CALLBACK Tesselator::errorCallback( GLenum errorCode, void* /*userData*/ )
-{
-	std::cerr << "CityGML tesselator error: " << gluErrorString( errorCode ) << std::endl;
-}
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* Contributors:
+*  - Manuel Garnier, BRGM - better normal computation
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#include "tesselator.h"
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#ifndef WIN32
+#	include <stdint.h>
+#endif
+
+typedef TesselatorNode Node;
+
+///////////////////////////////////////////////////////////////////////////////
+// Geometric predicates on the projected vertices, a positive cross product meaning a counter-clockwise turn
+
+static inline double cross( const Node* a, const Node* b, const Node* c )
+{
+	return ( b->x - a->x ) * ( c->y - a->y ) - ( b->y - a->y ) * ( c->x - a->x );
+}
+
+static inline int sign( double v ) { return ( v > 0. ) - ( v < 0. ); }
+
+static inline bool equals( const Node* a, const Node* b ) { return a->x == b->x && a->y == b->y; }
+
+// Is p inside the counter-clockwise triangle abc, boundaries included
+static inline bool pointInTriangle( double ax, double ay, double bx, double by, double cx, double cy, double px, double py )
+{
+	return ( cx - px ) * ( ay - py ) >= ( ax - px ) * ( cy - py ) &&
+		( ax - px ) * ( by - py ) >= ( bx - px ) * ( ay - py ) &&
+		( bx - px ) * ( cy - py ) >= ( cx - px ) * ( by - py );
+}
+
+// Does q lie on the segment pr, knowing that they are collinear
+static inline bool onSegment( const Node* p, const Node* q, const Node* r )
+{
+	return q->x <= std::max( p->x, r->x ) && q->x >= std::min( p->x, r->x ) && q->y <= std::max( p->y, r->y ) && q->y >= std::min( p->y, r->y );
+}
+
+static bool intersects( const Node* p1, const Node* q1, const Node* p2, const Node* q2 )
+{
+	int o1 = sign( cross( p1, q1, p2 ) );
+	int o2 = sign( cross( p1, q1, q2 ) );
+	int o3 = sign( cross( p2, q2, p1 ) );
+	int o4 = sign( cross( p2, q2, q1 ) );
+
+	if ( o1 != o2 && o3 != o4 ) return true;
+
+	return ( o1 == 0 && onSegment( p1, p2, q1 ) ) || ( o2 == 0 && onSegment( p1, q2, q1 ) ) ||
+		( o3 == 0 && onSegment( p2, p1, q2 ) ) || ( o4 == 0 && onSegment( p2, q1, q2 ) );
+}
+
+// Does the diagonal ab intersect one of the ring edges
+static bool intersectsPolygon( const Node* a, const Node* b )
+{
+	const Node* p = a;
+	do {
+		if ( p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i && intersects( p, p->next, a, b ) ) return true;
+		p = p->next;
+	} while ( p != a );
+	return false;
+}
+
+// Does the diagonal ab start inside the ring at a
+static inline bool locallyInside( const Node* a, const Node* b )
+{
+	return ( cross( a->prev, a, a->next ) > 0 ) ?
+		cross( a, b, a->next ) <= 0 && cross( a, a->prev, b ) <= 0 :
+		cross( a, b, a->prev ) > 0 || cross( a, a->next, b ) > 0;
+}
+
+// Is the middle of the diagonal ab inside the ring
+static bool middleInside( const Node* a, const Node* b )
+{
+	const Node* p = a;
+	bool inside = false;
+	double px = ( a->x + b->x ) / 2., py = ( a->y + b->y ) / 2.;
+	do {
+		if ( ( ( p->y > py ) != ( p->next->y > py ) ) && p->next->y != p->y &&
+			( px < ( p->next->x - p->x ) * ( py - p->y ) / ( p->next->y - p->y ) + p->x ) )
+			inside = !inside;
+		p = p->next;
+	} while ( p != a );
+	return inside;
+}
+
+static bool isValidDiagonal( const Node* a, const Node* b )
+{
+	return a->next->i != b->i && a->prev->i != b->i && !intersectsPolygon( a, b ) &&
+		( ( locallyInside( a, b ) && locallyInside( b, a ) && middleInside( a, b ) && ( cross( a->prev, a, b->prev ) != 0 || cross( a, b->prev, b ) != 0 ) ) ||
+		  ( equals( a, b ) && cross( a->prev, a, a->next ) < 0 && cross( b->prev, b, b->next ) < 0 ) );
+}
+
+static bool isEar( const Node* ear )
+{
+	const Node* a = ear->prev;
+	const Node* b = ear;
+	const Node* c = ear->next;
+
+	// Reflex or flat corner
+	if ( cross( a, b, c ) <= 0 ) return false;
+
+	// No reflex vertex may lie in the ear (the copies of its corners made by the holes bridges are not an issue)
+	for ( const Node* p = c->next; p != a; p = p->next )
+		if ( !equals( p, a ) && !equals( p, b ) && !equals( p, c ) &&
+			pointInTriangle( a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y ) && cross( p->prev, p, p->next ) <= 0 ) 
+			return false;
+
+	return true;
+}
+
+static inline void removeNode( Node* p )
+{
+	p->next->prev = p->prev;
+	p->prev->next = p->next;
+}
+
+// Remove the duplicated & collinear vertices of the ring between start and end
+static Node* filterPoints( Node* start, Node* end )
+{
+	if ( !start ) return start;
+	if ( !end ) end = start;
+
+	Node* p = start;
+	bool again;
+	do {
+		again = false;
+		if ( equals( p, p->next ) || cross( p->prev, p, p->next ) == 0 )
+		{
+			removeNode( p );
+			p = end = p->prev;
+			if ( p == p->next ) break;
+			again = true;
+		}
+		else p = p->next;
+	} while ( again || p != end );
+
+	return end;
+}
+
+static Node* getLeftmost( Node* start )
+{
+	Node* p = start;
+	Node* leftmost = start;
+	do {
+		if ( p->x < leftmost->x || ( p->x == leftmost->x && p->y < leftmost->y ) ) leftmost = p;
+		p = p->next;
+	} while ( p != start );
+	return leftmost;
+}
+
+static bool isLefter( const Node* a, const Node* b ) 
+{ 
+	return a->x < b->x || ( a->x == b->x && a->y < b->y ); 
+}
+
+// Does the sector of m contain the sector of p
+static inline bool sectorContainsSector( const Node* m, const Node* p )
+{
+	return cross( m->prev, m, p->prev ) > 0 && cross( p->next, m, m->next ) > 0;
+}
+
+// Find an exterior vertex visible from the leftmost vertex of the hole, to bridge them
+static Node* findHoleBridge( const Node* hole, Node* outer )
+{
+	Node* p = outer;
+	double hx = hole->x, hy = hole->y;
+	double qx = -HUGE_VAL;
+	Node* m = 0;
+
+	// Find the segment intersected by a ray going from the hole vertex to the left
+	do {
+		if ( hy <= p->y && hy >= p->next->y && p->next->y != p->y ) 
+		{
+			double x = p->x + ( hy - p->y ) * ( p->next->x - p->x ) / ( p->next->y - p->y );
+			if ( x <= hx && x > qx ) 
+			{
+				qx = x;
+				m = ( p->x < p->next->x ) ? p : p->next;
+				if ( x == hx ) return m;
+			}
+		}
+		p = p->next;
+	} while ( p != outer );
+
+	if ( !m ) return 0;
+
+	// Look for the vertices inside the triangle made of the hole vertex, the intersection & the segment endpoint:
+	// the bridge goes to the one making the smallest angle with the ray
+	Node* stop = m;
+	double mx = m->x, my = m->y;
+	double tanMin = HUGE_VAL;
+
+	p = m;
+	do {
+		if ( hx >= p->x && p->x >= mx && hx != p->x && 
+			pointInTriangle( hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y ) ) 
+		{
+			double tan = fabs( hy - p->y ) / ( hx - p->x );
+			if ( locallyInside( p, hole ) && 
+				( tan < tanMin || ( tan == tanMin && ( p->x > m->x || ( p->x == m->x && sectorContainsSector( m, p ) ) ) ) ) ) 
+			{
+				m = p;
+				tanMin = tan;
+			}
+		}
+		p = p->next;
+	} while ( p != stop );
+
+	return m;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Tesselator::Tesselator( void ) : _vertices( 0 ), _indices( 0 )
+{
+#ifdef USE_GLU
+	_tobj = 0;
+#endif
+}
+
+Tesselator::~Tesselator( void ) 
+{
+#ifdef USE_GLU
+	if ( _tobj ) gluDeleteTess( _tobj );
+#endif
+}
+
+void Tesselator::init( unsigned int verticesCount, const TVec3d& normal, std::vector<TVec3d>& vertices, std::vector<unsigned int>& indices )
+{
+	_normal = normal;
+
+	_vertices = &vertices;
+	_vertices->reserve( _vertices->size() + verticesCount );
+	_indices = &indices;
+	_firstIndex = indices.size();
+	_contours.clear();
+}
+
+void Tesselator::addContour( const std::vector<TVec3d>& pts )
+{		
+	unsigned int len = pts.size();
+	if ( len < 3 ) return;
+
+	_contours.push_back( _vertices->size() );
+	_vertices->insert( _vertices->end(), pts.begin(), pts.end() );
+}
+
+void Tesselator::compute( void ) 
+{
+	if ( computeEarClipping() ) return;
+
+#ifdef USE_GLU
+	_indices->resize( _firstIndex );
+	computeGLU();
+#else
+	std::cerr << "CityGML tesselator: a polygon could not be fully tesselated" << std::endl;
+#endif
+}
+
+bool Tesselator::computeEarClipping( void )
+{
+	_nodes.clear();
+	_indices->resize( _firstIndex );
+
+	if ( _contours.empty() ) return true;
+
+	_indices->reserve( _firstIndex + 3 * ( _vertices->size() - _contours[0] + 2 * _contours.size() ) );
+
+	Node* outer = linkContour( _contours[0], ( _contours.size() > 1 ) ? _contours[1] : _vertices->size(), true );
+	if ( !outer || outer->next == outer->prev ) return true;
+
+	if ( _contours.size() > 1 ) outer = eliminateHoles( outer );
+
+	return clipEars( outer, 0 );
+}
+
+Tesselator::Node* Tesselator::createNode( unsigned int i, double x, double y, Node* last )
+{
+	_nodes.push_back( Node() );
+	Node* p = &_nodes.back();
+	p->i = i;
+	p->x = x;
+	p->y = y;
+
+	if ( !last ) 
+	{
+		p->prev = p;
+		p->next = p;
+	}
+	else 
+	{
+		p->next = last->next;
+		p->prev = last;
+		last->next->prev = p;
+		last->next = p;
+	}
+	return p;
+}
+
+// Dominant plane of the normal, its axes being swapped when the normal points backward
+void Tesselator::getProjectionAxes( const TVec3d& normal, int& u, int& v )
+{
+	double nx = fabs( normal.x ), ny = fabs( normal.y ), nz = fabs( normal.z );
+	u = 0; v = 1;
+	bool flip = normal.z < 0;
+	if ( nx > nz && nx >= ny ) { u = 1; v = 2; flip = normal.x < 0; }
+	else if ( ny > nz && ny > nx ) { u = 2; v = 0; flip = normal.y < 0; }
+	if ( flip ) std::swap( u, v );
+}
+
+// Link the vertices [first, last) in a ring of the wanted orientation once projected on the dominant plane of the normal
+Tesselator::Node* Tesselator::linkContour( unsigned int first, unsigned int last, bool ccw )
+{
+	int u, v;
+	getProjectionAxes( _normal, u, v );
+
+	double area = 0.;
+	for ( unsigned int i = first, j = last - 1; i < last; j = i++ )
+		area += ( (*_vertices)[j][u] - (*_vertices)[i][u] ) * ( (*_vertices)[i][v] + (*_vertices)[j][v] );
+
+	Node* node = 0;
+	if ( ccw == ( area > 0 ) )
+		for ( unsigned int i = first; i < last; i++ ) node = createNode( i, (*_vertices)[i][u], (*_vertices)[i][v], node );
+	else
+		for ( unsigned int i = last; i-- > first; ) node = createNode( i, (*_vertices)[i][u], (*_vertices)[i][v], node );
+
+	if ( node && equals( node, node->next ) ) 
+	{
+		Node* next = node->next;
+		removeNode( node );
+		node = next;
+	}
+
+	return node;
+}
+
+// Connect the holes to the exterior ring, from the leftmost one to the rightmost one
+Tesselator::Node* Tesselator::eliminateHoles( Node* outer )
+{
+	std::vector< Node* > holes;
+	for ( unsigned int i = 1; i < _contours.size(); i++ )
+	{
+		Node* list = linkContour( _contours[i], ( i + 1 < _contours.size() ) ? _contours[i + 1] : _vertices->size(), false );
+		if ( list ) holes.push_back( getLeftmost( list ) );
+	}
+
+	std::sort( holes.begin(), holes.end(), isLefter );
+
+	for ( unsigned int i = 0; i < holes.size(); i++ )
+	{
+		Node* bridge = findHoleBridge( holes[i], outer );
+		if ( !bridge ) continue;
+
+		Node* bridgeReverse = splitPolygon( bridge, holes[i] );
+		filterPoints( bridgeReverse, bridgeReverse->next );
+		outer = filterPoints( bridge, bridge->next );
+	}
+
+	return outer;
+}
+
+// Link a to b with a diagonal, splitting the ring in two; return the copy of b linked to the copy of a
+Tesselator::Node* Tesselator::splitPolygon( Node* a, Node* b )
+{
+	Node* a2 = createNode( a->i, a->x, a->y, 0 );
+	Node* b2 = createNode( b->i, b->x, b->y, 0 );
+	Node* an = a->next;
+	Node* bp = b->prev;
+
+	a->next = b;
+	b->prev = a;
+
+	a2->next = an;
+	an->prev = a2;
+
+	b2->next = a2;
+	a2->prev = b2;
+
+	bp->next = b2;
+	b2->prev = bp;
+
+	return b2;
+}
+
+// Clip the ears of the ring; when none can be found, the duplicated points are removed (pass 1), 
+// then the local self-intersections are cured (pass 2) and eventually the ring is split in two
+bool Tesselator::clipEars( Node* ear, int pass )
+{
+	if ( !ear ) return true;
+
+	Node* stop = ear;
+
+	while ( ear->prev != ear->next )
+	{
+		Node* prev = ear->prev;
+		Node* next = ear->next;
+
+		if ( isEar( ear ) )
+		{
+			addTriangle( prev, ear, next );
+			removeNode( ear );
+
+			// Skipping the next vertex leads to less sliver triangles
+			ear = next->next;
+			stop = next->next;
+			continue;
+		}
+
+		ear = next;
+
+		if ( ear == stop )
+		{
+			if ( pass == 0 ) return clipEars( filterPoints( ear, 0 ), 1 );
+			if ( pass == 1 ) return clipEars( cureLocalIntersections( filterPoints( ear, 0 ) ), 2 );
+			return splitClip( ear );
+		}
+	}
+
+	return true;
+}
+
+Tesselator::Node* Tesselator::cureLocalIntersections( Node* start )
+{
+	Node* p = start;
+	do {
+		Node* a = p->prev;
+		Node* b = p->next->next;
+
+		if ( !equals( a, b ) && intersects( a, p, p->next, b ) && locallyInside( a, b ) && locallyInside( b, a ) ) 
+		{
+			addTriangle( a, p, b );
+
+			removeNode( p );
+			removeNode( p->next );
+
+			p = start = b;
+		}
+		p = p->next;
+	} while ( p != start );
+
+	return filterPoints( p, 0 );
+}
+
+// Split the ring along a valid diagonal and clip both halves
+bool Tesselator::splitClip( Node* start )
+{
+	Node* a = start;
+	do {
+		for ( Node* b = a->next->next; b != a->prev; b = b->next )
+		{
+			if ( a->i == b->i || !isValidDiagonal( a, b ) ) continue;
+
+			Node* c = splitPolygon( a, b );
+
+			a = filterPoints( a, a->next );
+			c = filterPoints( c, c->next );
+
+			bool ok = clipEars( a, 0 );
+			return clipEars( c, 0 ) && ok;
+		}
+		a = a->next;
+	} while ( a != start );
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef USE_GLU
+
+void Tesselator::computeGLU( void )
+{
+	if ( !_tobj )
+	{
+		_tobj = gluNewTess(); 
+
+		gluTessCallback( _tobj, GLU_TESS_VERTEX_DATA, (GLU_TESS_CALLBACK)&vertexCallback );
+		gluTessCallback( _tobj, GLU_TESS_BEGIN_DATA, (GLU_TESS_CALLBACK)&beginCallback );
+		gluTessCallback( _tobj, GLU_TESS_END_DATA, (GLU_TESS_CALLBACK)&endCallback );
+		gluTessCallback( _tobj, GLU_TESS_COMBINE_DATA, (GLU_TESS_CALLBACK)&combineCallback );
+		gluTessCallback( _tobj, GLU_TESS_ERROR_DATA, (GLU_TESS_CALLBACK)&errorCallback );
+	}
+
+	gluTessBeginPolygon( _tobj, this ); 
+
+	gluTessProperty( _tobj, GLU_TESS_WINDING_RULE, GLU_TESS_WINDING_ODD );
+	gluTessNormal( _tobj, _normal.x, _normal.y, _normal.z );
+
+	_curIndices.clear();
+
+	// The vertices added by the combine callback come after the contours ones
+	unsigned int len = _vertices->size();
+	for ( unsigned int c = 0; c < _contours.size(); c++ )
+	{
+		unsigned int last = ( c + 1 < _contours.size() ) ? _contours[c + 1] : len;
+
+		gluTessBeginContour( _tobj );
+		for ( unsigned int i = _contours[c]; i < last; i++ ) 
+			gluTessVertex( _tobj, &((*_vertices)[i][0]), (void*)(intptr_t)i );
+		gluTessEndContour( _tobj );
+	}
+
+	gluTessEndPolygon( _tobj );  
+}
+
+void CALLBACK Tesselator::beginCallback( GLenum which, void* userData ) 
+{
+	Tesselator *tess = (Tesselator*)userData;
+	tess->_curMode = which;
+}
+
+void CALLBACK Tesselator::vertexCallback( GLvoid *data, void* userData ) 
+{
+	Tesselator *tess = (Tesselator*)userData;
+	tess->_curIndices.push_back( (intptr_t)data );
+}
+
+void CALLBACK Tesselator::combineCallback( GLdouble coords[3], void* vertex_data[4], GLfloat weight[4], void** outData, void* userData )
+{
+	Tesselator *tess = (Tesselator*)userData;
+	unsigned int npoint = tess->_vertices->size();
+	tess->_vertices->push_back( TVec3d( coords[0], coords[1], coords[2] ) );
+
+	*outData = (void*)(intptr_t)npoint;
+}
+
+void CALLBACK Tesselator::endCallback( void* userData ) 
+{
+	Tesselator *tess = (Tesselator*)userData;
+
+	unsigned int len = tess->_curIndices.size();
+
+	switch ( tess->_curMode ) 
+	{
+	case GL_TRIANGLES:
+		for ( unsigned int i = 0; i < len; i++ ) tess->_indices->push_back( tess->_curIndices[i] );
+		break;
+	case GL_TRIANGLE_FAN:
+	case GL_TRIANGLE_STRIP: 
+		{
+			unsigned int first = tess->_curIndices[0];
+			unsigned int prev = tess->_curIndices[1];
+
+			for ( unsigned int i = 2; i < len; i++ ) 
+			{
+				if ( tess->_curMode == GL_TRIANGLE_FAN || i%2 == 0 ) tess->_indices->push_back( first );
+				tess->_indices->push_back( prev );
+				if ( tess->_curMode == GL_TRIANGLE_STRIP )
+				{
+					if ( i%2 == 1) tess->_indices->push_back( first );
+					first = prev;
+				}
+				prev = tess->_curIndices[i];
+				tess->_indices->push_back( prev );
+			}
+		}
+		break;
+	default: std::cerr << "CityGML tesselator: non-supported GLU tesselator primitive " << tess->_curMode << std::endl;
+	}
+	tess->_curIndices.clear();
+}
+
+void CALLBACK Tesselator::errorCallback( GLenum errorCode, void* /*userData*/ )
+{
+	std::cerr << "CityGML tesselator error: " << gluErrorString( errorCode ) << std::endl;
+}
+
+#endif // USE_GLU
@@ -1,75 +1,127 @@
-/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
-*
-* This file is part of libcitygml library
-* http://code.google.com/p/libcitygml
-*
-* libcitygml is free software: you can redistribute it and/or modify
-* it under the terms of the GNU Lesser General Public License as published by
-* the Free Software Foundation, either version 2.1 of the License, or
-* (at your option) any later version.
-*
-* libcitygml is distributed in the hope that it will be useful,
-* but WITHOUT ANY WARRANTY; without even the implied warranty of
-* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-* GNU Lesser General Public License for more details.
-*/
-
-#ifndef __TESSELATOR_H__
-#define __TESSELATOR_H__
-
-#ifdef WIN32
-#	include <windows.h>
-#else
-#	define CALLBACK
-#	define APIENTRY
-#endif
-
-#ifdef __APPLE__
-  #include <OpenGL/glu.h>
-#else
-  #include <GL/glu.h>
-#endif
-
-#include "vecs.h"
-#include <vector>
-
-// GLU based polygon tesselator
-class Tesselator 
-{		
-public:
-	Tesselator( void ); 
-	~Tesselator( void );
-
-	void init( unsigned int verticesCount, const TVec3d& normal, GLenum winding_rule = GLU_TESS_WINDING_ODD );
-
-	// Add a new contour - add the exterior ring first, then interiors 
-	void addContour( const std::vector<TVec3d>&, const std::vector<TVec2f>& );
-
-	// Let's tesselate!
-	void compute( void );
-
-	// Tesselation result access
-	inline const std::vector<TVec3d>& getVertices( void ) const { return _vertices; }
-	inline const std::vector<TVec2f>& getTexCoords( void ) const { return _texCoords; }
-	inline const std::vector<unsigned int>& getIndices( void ) const { return _indices; }
-
-private:
-	typedef void (APIENTRY *GLU_TESS_CALLBACK)();
-	static void CALLBACK beginCallback( GLenum, void* );
-	static void CALLBACK vertexCallback( GLvoid*, void* );
-	static void CALLBACK combineCallback( GLdouble[3], void* [4], GLfloat [4], void** , void* );
-	static void CALLBACK endCallback( void* );
-	static void CALLBACK errorCallback( GLenum, void* );	
-
-private:
-	GLUtesselator *_tobj;
-	GLenum  _curMode;
-
-	std::vector<TVec3d> _vertices;		
-	std::vector<TVec2f> _texCoords;
-	std::vector<unsigned int> _indices;
-
-	std::vector<unsigned int> _curIndices;
-};
-
-#endif // __TESSELATOR_H__
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+#ifndef __TESSELATOR_H__
+#define __TESSELATOR_H__
+
+#ifdef USE_GLU
+#	ifdef WIN32
+#		include <windows.h>
+#	else
+#		define CALLBACK
+#		define APIENTRY
+#	endif
+
+#	ifdef __APPLE__
+#		include <OpenGL/glu.h>
+#	else
+#		include <GL/glu.h>
+#	endif
+#endif
+
+#include "vecs.h"
+#include <vector>
+#include <deque>
+
+// Ear clipping vertex, linked to its neighbours in the ring being clipped
+struct TesselatorNode
+{
+	unsigned int i;		// index of the vertex
+	double x, y;		// projected coordinates
+	TesselatorNode* prev;
+	TesselatorNode* next;
+};
+
+// Polygon tesselator: ear clipping of the contours projected on their dominant plane, the holes being 
+// bridged to the exterior contour. When built with GLU, it is used as a fallback for the polygons that
+// cannot be clipped (eg. self-intersecting ones).
+class Tesselator 
+{		
+public:
+	Tesselator( void ); 
+	~Tesselator( void );
+
+	// Start a new tesselation: the contours vertices, then the triangles indices, are appended to the given buffers
+	void init( unsigned int verticesCount, const TVec3d& normal, std::vector<TVec3d>& vertices, std::vector<unsigned int>& indices );
+
+	// Add a new contour - add the exterior ring first, then interiors 
+	void addContour( const std::vector<TVec3d>& );
+
+	// Let's tesselate!
+	void compute( void );
+
+	// Get the axes of the plane on which the contours are projected, so that they keep their orientation as seen from the normal
+	static void getProjectionAxes( const TVec3d& normal, int& u, int& v );
+
+	// Tesselation result access
+	inline const std::vector<TVec3d>& getVertices( void ) const { return *_vertices; }
+	inline const std::vector<unsigned int>& getIndices( void ) const { return *_indices; }
+
+private:
+	typedef TesselatorNode Node;
+
+	Node* createNode( unsigned int i, double x, double y, Node* last );
+	Node* linkContour( unsigned int first, unsigned int last, bool ccw );
+	Node* eliminateHoles( Node* outer );
+	Node* splitPolygon( Node* a, Node* b );
+
+	bool clipEars( Node* ear, int pass );
+	bool splitClip( Node* start );
+	Node* cureLocalIntersections( Node* start );
+
+	inline void addTriangle( const Node* a, const Node* b, const Node* c ) 
+	{ 
+		_indices->push_back( a->i ); 
+		_indices->push_back( b->i ); 
+		_indices->push_back( c->i ); 
+	}
+
+	bool computeEarClipping( void );
+
+#ifdef USE_GLU
+	void computeGLU( void );
+
+	typedef void (APIENTRY *GLU_TESS_CALLBACK)();
+	static void CALLBACK beginCallback( GLenum, void* );
+	static void CALLBACK vertexCallback( GLvoid*, void* );
+	static void CALLBACK combineCallback( GLdouble[3], void* [4], GLfloat [4], void** , void* );
+	static void CALLBACK endCallback( void* );
+	static void CALLBACK errorCallback( GLenum, void* );	
+#endif
+
+private:
+	TVec3d _normal;
+
+	// Destination buffers, owned by the caller
+	std::vector<TVec3d>* _vertices;
+	std::vector<unsigned int>* _indices;
+	unsigned int _firstIndex;
+
+	// First vertex of each contour
+	std::vector<unsigned int> _contours;
+
+	// Ear clipping state: the projected vertices, linked as rings
+	std::deque<Node> _nodes;
+
+#ifdef USE_GLU
+	GLUtesselator *_tobj;
+	GLenum  _curMode;
+
+	std::vector<unsigned int> _curIndices;
+#endif
+};
+
+#endif // __TESSELATOR_H__
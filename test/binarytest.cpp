@@ -0,0 +1,479 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+// Round trip of a parsed model through the binary files (save_binary, load_binary & map_binary),
+// and rejection of the damaged files
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "citygml.h"
+#include "binaryformat.h"
+
+using namespace citygml;
+
+static const char* SAMPLE =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<CityModel xmlns=\"http://www.opengis.net/citygml/1.0\" xmlns:gml=\"http://www.opengis.net/gml\" xmlns:bldg=\"http://www.opengis.net/citygml/building/1.0\""
+	" xmlns:app=\"http://www.opengis.net/citygml/appearance/1.0\" xmlns:gen=\"http://www.opengis.net/citygml/generics/1.0\">\n"
+	"<gml:boundedBy><gml:Envelope srsName=\"EPSG:25832\"><gml:lowerCorner>0 0 0</gml:lowerCorner><gml:upperCorner>50 10 20</gml:upperCorner></gml:Envelope></gml:boundedBy>\n"
+	"<cityObjectMember><bldg:Building gml:id=\"B0\">\n"
+	"<gen:stringAttribute name=\"owner\"><gen:value>Owner 0</gen:value></gen:stringAttribute>\n"
+	"<gen:doubleAttribute name=\"area\"><gen:value>100.5</gen:value></gen:doubleAttribute>\n"
+	"<gen:intAttribute name=\"floors\"><gen:value>3</gen:value></gen:intAttribute>\n"
+	"<bldg:measuredHeight uom=\"m\">10</bldg:measuredHeight>\n"
+	"<bldg:boundedBy><bldg:WallSurface gml:id=\"B0_W0\"><bldg:lod2MultiSurface><gml:MultiSurface><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B0_W0_P\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">0 0 0 10 0 0 10 0 10 0 0 10 0 0 0</gml:posList></gml:LinearRing></gml:exterior>"
+	"<gml:interior><gml:LinearRing><gml:posList srsDimension=\"3\">3 0 3 3 0 6 6 0 6 6 0 3 3 0 3</gml:posList></gml:LinearRing></gml:interior></gml:Polygon>"
+	"</gml:surfaceMember></gml:MultiSurface></bldg:lod2MultiSurface></bldg:WallSurface></bldg:boundedBy>\n"
+	"<bldg:boundedBy><bldg:WallSurface gml:id=\"B0_W1\"><bldg:lod2MultiSurface><gml:MultiSurface><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B0_W1_P\"><gml:exterior><gml:LinearRing gml:id=\"B0_W1_P_R\"><gml:posList srsDimension=\"3\">10 0 0 10 10 0 10 10 10 10 0 10 10 0 0</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+	"</gml:surfaceMember></gml:MultiSurface></bldg:lod2MultiSurface></bldg:WallSurface></bldg:boundedBy>\n"
+	"<bldg:boundedBy><bldg:RoofSurface gml:id=\"B0_R\"><bldg:lod2MultiSurface><gml:MultiSurface><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B0_R_P\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">0 0 10 10 0 10 10 5 10 5 5 11 5 10 10 0 10 10 0 0 10</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+	"</gml:surfaceMember></gml:MultiSurface></bldg:lod2MultiSurface></bldg:RoofSurface></bldg:boundedBy>\n"
+	"</bldg:Building></cityObjectMember>\n"
+	"<cityObjectMember><bldg:Building gml:id=\"B1\">\n"
+	"<gen:stringAttribute name=\"owner\"><gen:value>Owner 1</gen:value></gen:stringAttribute>\n"
+	"<bldg:lod1Solid><gml:Solid><gml:exterior><gml:CompositeSurface><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B1_P0\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">40 0 0 50 0 0 50 10 0 40 10 0 40 0 0</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+	"</gml:surfaceMember><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B1_P1\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">40 0 20 40 10 20 50 10 20 50 0 20 40 0 20</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+	"</gml:surfaceMember><gml:surfaceMember>"
+	"<gml:Polygon gml:id=\"B1_P2\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">40 0 0 40 0 20 50 0 20 50 0 0 40 0 0</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+	"</gml:surfaceMember></gml:CompositeSurface></gml:exterior></gml:Solid></bldg:lod1Solid>\n"
+	"</bldg:Building></cityObjectMember>\n"
+	"<app:appearanceMember><app:Appearance><app:theme>t</app:theme>\n"
+	"<app:surfaceDataMember><app:ParameterizedTexture gml:id=\"TEX1\"><app:imageURI>tex/facade.jpg</app:imageURI><app:wrapMode>mirror</app:wrapMode>"
+	"<app:target uri=\"#B0_W1_P\"><app:TexCoordList><app:textureCoordinates ring=\"#B0_W1_P_R\">0 0 1 0 1 1 0 1 0 0</app:textureCoordinates></app:TexCoordList></app:target>"
+	"</app:ParameterizedTexture></app:surfaceDataMember>\n"
+	"<app:surfaceDataMember><app:X3DMaterial gml:id=\"MAT1\"><app:diffuseColor>0.5 0.2 0.1</app:diffuseColor><app:shininess>0.3</app:shininess><app:isFront>true</app:isFront>"
+	"<app:target>#B0_W0_P</app:target><app:target>#B1_P1</app:target>"
+	"</app:X3DMaterial></app:surfaceDataMember></app:Appearance></app:appearanceMember>\n"
+	"</CityModel>\n";
+
+static const char* FILENAME = "binarytest.cgb";
+
+static int failures = 0;
+
+#define CHECK( cond ) do { if ( !( cond ) ) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; failures++; } } while ( 0 )
+
+///////////////////////////////////////////////////////////////////////////////
+// Comparison of the loaded & mapped models with the parsed one
+
+template< class T > static bool equal( const ArrayView<T>& a, const ArrayView<T>& b )
+{
+	if ( a.size() != b.size() ) return false;
+	for ( unsigned int i = 0; i < a.size(); i++ ) if ( a[i] != b[i] ) return false;
+	return true;
+}
+
+// The objects without gml:id have synthetic ids, which are not saved
+static bool sameId( const Object& a, const Object& b )
+{
+	return a.hasId() == b.hasId() && ( !a.hasId() || a.getId() == b.getId() );
+}
+
+static bool sameId( const Object& a, const MappedObject& b )
+{
+	return a.hasId() ? a.getId() == b.getId() : *b.getId() == 0;
+}
+
+static void compareMaterial( const Material* a, const Material* b )
+{
+	CHECK( !a == !b );
+	if ( !a || !b ) return;
+	CHECK( sameId( *a, *b ) );
+	CHECK( a->getDiffuse() == b->getDiffuse() && a->getShininess() == b->getShininess() && a->getIsFront() == b->getIsFront() );
+}
+
+static void compareMaterial( const Material* a, const MappedAppearance& b )
+{
+	CHECK( !a == !b.isValid() );
+	if ( !a || !b.isValid() ) return;
+	CHECK( b.isMaterial() && sameId( *a, b ) );
+	CHECK( a->getDiffuse() == b.getDiffuse() && a->getShininess() == b.getShininess() && a->getIsFront() == b.getIsFront() );
+}
+
+static void compareTexture( const Texture* a, const Texture* b )
+{
+	CHECK( !a == !b );
+	if ( !a || !b ) return;
+	CHECK( sameId( *a, *b ) && a->getUrl() == b->getUrl() && a->getWrapMode() == b->getWrapMode() );
+}
+
+static void compareTexture( const Texture* a, const MappedAppearance& b )
+{
+	CHECK( !a == !b.isValid() );
+	if ( !a || !b.isValid() ) return;
+	CHECK( b.isTexture() && sameId( *a, b ) && a->getUrl() == b.getUrl() && a->getWrapMode() == b.getWrapMode() );
+}
+
+static bool sameRange( const PolygonRange& a, const PolygonRange& b )
+{
+	return a.id == b.id && a.vertexOffset == b.vertexOffset && a.vertexCount == b.vertexCount && a.indexOffset == b.indexOffset && a.indexCount == b.indexCount;
+}
+
+static void compareSources( const Polygon* a, const Polygon* b )
+{
+	CHECK( a->getSources().size() == b->getSources().size() );
+	for ( unsigned int i = 0; i < std::min( a->getSources().size(), b->getSources().size() ); i++ ) CHECK( sameRange( a->getSources()[i], b->getSources()[i] ) );
+}
+
+static void compareSources( const Polygon* a, const MappedPolygon& b )
+{
+	CHECK( a->getSources().size() == b.getSourcesCount() );
+	for ( unsigned int i = 0; i < std::min( (unsigned int)a->getSources().size(), b.getSourcesCount() ); i++ ) CHECK( sameRange( a->getSources()[i], b.getSource( i ) ) );
+}
+
+static void compareAttributes( const AttributesMap& a, const AttributesMap& b )
+{
+	CHECK( a.size() == b.size() );
+	for ( AttributesMap::const_iterator it = a.begin(); it != a.end(); ++it )
+	{
+		AttributesMap::const_iterator found = b.find( it->first );
+		CHECK( found != b.end() );
+		if ( found == b.end() ) continue;
+		CHECK( it->second.getType() == found->second.getType() && it->second.asString() == found->second.asString() );
+		CHECK( it->second.asDouble() == found->second.asDouble() );
+	}
+}
+
+static void compareAttributes( const AttributesMap& a, const MappedObject& b )
+{
+	CHECK( a.size() == b.getAttributesCount() );
+	for ( unsigned int i = 0; i < b.getAttributesCount(); i++ )
+	{
+		AttributesMap::const_iterator found = a.find( b.getAttributeName( i ) );
+		CHECK( found != a.end() );
+		if ( found == a.end() ) continue;
+		AttributeValue value = b.getAttributeValue( i );
+		CHECK( found->second.getType() == value.getType() && found->second.asString() == value.asString() );
+		CHECK( found->second.asDouble() == value.asDouble() );
+	}
+}
+
+static void compareObject( const CityObject* a, const CityObject* b )
+{
+	CHECK( sameId( *a, *b ) && a->getType() == b->getType() );
+	compareAttributes( a->getAttributes(), b->getAttributes() );
+	CHECK( a->size() == b->size() && a->getChildCount() == b->getChildCount() );
+	if ( a->size() != b->size() || a->getChildCount() != b->getChildCount() ) return;
+
+	for ( unsigned int i = 0; i < a->size(); i++ )
+	{
+		const Geometry& ga = *a->getGeometry( i );
+		const Geometry& gb = *b->getGeometry( i );
+		CHECK( sameId( ga, gb ) && ga.getType() == gb.getType() && ga.getLOD() == gb.getLOD() && ga.size() == gb.size() );
+		if ( ga.size() != gb.size() ) continue;
+
+		for ( unsigned int j = 0; j < ga.size(); j++ )
+		{
+			const Polygon* pa = ga[j];
+			const Polygon* pb = gb[j];
+			CHECK( sameId( *pa, *pb ) );
+			CHECK( equal( pa->getVertices(), pb->getVertices() ) );
+			CHECK( equal( pa->getIndices(), pb->getIndices() ) );
+			CHECK( equal( pa->getTexCoords(), pb->getTexCoords() ) );
+			CHECK( equal( pa->getNormals(), pb->getNormals() ) );
+			compareSources( pa, pb );
+			compareMaterial( pa->getMaterial(), pb->getMaterial() );
+			compareTexture( pa->getTexture(), pb->getTexture() );
+		}
+	}
+
+	for ( unsigned int i = 0; i < a->getChildCount(); i++ ) compareObject( a->getChild( i ), b->getChild( i ) );
+}
+
+static void compareObject( const CityObject* a, const MappedCityObject& b )
+{
+	CHECK( sameId( *a, b ) && a->getType() == b.getType() );
+	compareAttributes( a->getAttributes(), b );
+	CHECK( a->size() == b.size() && a->getChildCount() == b.getChildCount() );
+	if ( a->size() != b.size() || a->getChildCount() != b.getChildCount() ) return;
+
+	for ( unsigned int i = 0; i < a->size(); i++ )
+	{
+		const Geometry& ga = *a->getGeometry( i );
+		MappedGeometry gb = b.getGeometry( i );
+		CHECK( sameId( ga, gb ) && ga.getType() == gb.getType() && ga.getLOD() == gb.getLOD() && ga.size() == gb.size() );
+		if ( ga.size() != gb.size() ) continue;
+
+		for ( unsigned int j = 0; j < ga.size(); j++ )
+		{
+			const Polygon* pa = ga[j];
+			MappedPolygon pb = gb[j];
+			CHECK( sameId( *pa, pb ) );
+			CHECK( equal( pa->getVertices(), pb.getVertices() ) );
+			CHECK( equal( pa->getIndices(), pb.getIndices() ) );
+			CHECK( equal( pa->getTexCoords(), pb.getTexCoords() ) );
+			CHECK( equal( pa->getNormals(), pb.getNormals() ) );
+			compareSources( pa, pb );
+			compareMaterial( pa->getMaterial(), pb.getMaterial() );
+			compareTexture( pa->getTexture(), pb.getTexture() );
+		}
+	}
+
+	for ( unsigned int i = 0; i < a->getChildCount(); i++ ) compareObject( a->getChild( i ), b.getChild( i ) );
+}
+
+// Count the textured polygons & those with a material, to make sure that the sample exercises them.
+// Only the textured polygons have texture coordinates, one per vertex.
+static void countAppearances( const CityObject* obj, unsigned int& textured, unsigned int& materials )
+{
+	for ( unsigned int i = 0; i < obj->size(); i++ )
+		for ( unsigned int j = 0; j < obj->getGeometry( i )->size(); j++ )
+		{
+			const Polygon* p = (*obj->getGeometry( i ))[j];
+			if ( !p->getTexCoords().empty() ) 
+			{
+				CHECK( p->getTexture() && p->getTexCoords().size() == p->getVertices().size() );
+				textured++;
+			}
+			if ( p->getMaterial() ) materials++;
+		}
+	for ( unsigned int i = 0; i < obj->getChildCount(); i++ ) countAppearances( obj->getChild( i ), textured, materials );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Damaged files
+
+static std::string readFile( const std::string& fileName )
+{
+	std::ifstream in( fileName.c_str(), std::ios::binary );
+	std::ostringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static void writeFile( const std::string& fileName, const std::string& data )
+{
+	std::ofstream out( fileName.c_str(), std::ios::binary | std::ios::trunc );
+	out.write( data.data(), data.size() );
+}
+
+// Check that a damaged file is rejected by both readers
+static bool isRejected( const std::string& data )
+{
+	writeFile( FILENAME, data );
+	CityModel* model = load_binary( FILENAME );
+	MappedCityModel* mapped = map_binary( FILENAME );
+	bool rejected = !model && !mapped;
+	delete model;
+	delete mapped;
+	return rejected;
+}
+
+static unsigned int countObjects( const MappedCityObject& obj )
+{
+	if ( !obj.isValid() ) return 0;
+	unsigned int count = 1;
+	for ( unsigned int i = 0; i < obj.getChildCount(); i++ ) count += countObjects( obj.getChild( i ) );
+	return count;
+}
+
+// Check that a damaged objects hierarchy is rejected by the loader, and cut by the mapped model at the damaged reference:
+// it is only checked on access, so that mapping a file does not walk all its objects
+static bool isHierarchyRejected( const std::string& data )
+{
+	writeFile( FILENAME, data );
+	CityModel* model = load_binary( FILENAME );
+	MappedCityModel* mapped = map_binary( FILENAME );
+	unsigned int reached = 0;
+	for ( unsigned int i = 0; mapped && i < mapped->getRootsCount(); i++ ) reached += countObjects( mapped->getRoot( i ) );
+	bool rejected = !model && mapped && reached < mapped->size();
+	delete model;
+	delete mapped;
+	return rejected;
+}
+
+static binary::BlockEntry* findBlock( std::string& data, uint32_t type )
+{
+	binary::FileHeader* header = (binary::FileHeader*)&data[0];
+	binary::BlockEntry* entries = (binary::BlockEntry*)&data[ sizeof( binary::FileHeader ) ];
+	for ( uint32_t i = 0; i < header->blocksCount; i++ ) if ( entries[i].type == type ) return &entries[i];
+	return 0;
+}
+
+template< class T > static T* getBlock( std::string& data, uint32_t type )
+{
+	return (T*)&data[ findBlock( data, type )->offset ];
+}
+
+static void checkDamagedFiles( const std::string& original )
+{
+	// Truncated files
+	for ( size_t size = 0; size < original.size(); size += 1 + size / 8 )
+		CHECK( isRejected( original.substr( 0, size ) ) );
+
+	// Blocks directory pointing out of the file, or a missing block
+	{
+		std::string data = original;
+		findBlock( data, binary::BT_Vertices )->offset = data.size();
+		CHECK( isRejected( data ) );
+
+		data = original;
+		findBlock( data, binary::BT_Indices )->size += 8;
+		CHECK( isRejected( data ) );
+
+		data = original;
+		findBlock( data, binary::BT_Polygons )->count++;
+		CHECK( isRejected( data ) );
+
+		data = original;
+		findBlock( data, binary::BT_Objects )->type = 0x200;
+		CHECK( isRejected( data ) );
+
+		data = original;
+		( (binary::FileHeader*)&data[0] )->blocksCount = 1000;
+		CHECK( isRejected( data ) );
+	}
+
+	// Polygon index out of its vertices: rejected by the loader, empty in the mapped polygon
+	{
+		std::string data = original;
+		const binary::PolygonRecord& polygon = getBlock< binary::PolygonRecord >( data, binary::BT_Polygons )[0];
+		getBlock< uint32_t >( data, binary::BT_Indices )[ polygon.indexOffset + polygon.indexCount - 1 ] = polygon.vertexCount;
+		writeFile( FILENAME, data );
+
+		CityModel* model = load_binary( FILENAME );
+		CHECK( !model );
+		delete model;
+		MappedCityModel* mapped = map_binary( FILENAME );
+		CHECK( mapped && MappedPolygon( mapped, 0 ).getIndices().empty() && !MappedPolygon( mapped, 0 ).getVertices().empty() );
+		delete mapped;
+	}
+
+	// Source ranges out of their merged polygon ones: rejected by the loader, empty in the mapped polygon
+	std::string copy = original;
+	const binary::PolygonRecord* polygons = getBlock< binary::PolygonRecord >( copy, binary::BT_Polygons );
+	uint32_t polygonsCount = findBlock( copy, binary::BT_Polygons )->count, merged = 0;
+	while ( merged < polygonsCount && polygons[ merged ].sourcesCount == 0 ) merged++;
+	CHECK( merged < polygonsCount );
+	for ( unsigned int k = 0; k < 2 && merged < polygonsCount; k++ )
+	{
+		std::string data = original;
+		const binary::PolygonRecord& polygon = getBlock< binary::PolygonRecord >( data, binary::BT_Polygons )[ merged ];
+		binary::SourceRecord& source = getBlock< binary::SourceRecord >( data, binary::BT_Sources )[ polygon.sourcesFirst ];
+		if ( k == 0 ) source.vertexCount = polygon.vertexCount + 1;
+		else source.indexOffset = polygon.indexCount;
+		writeFile( FILENAME, data );
+
+		CityModel* model = load_binary( FILENAME );
+		CHECK( !model );
+		delete model;
+		MappedCityModel* mapped = map_binary( FILENAME );
+		CHECK( mapped && MappedPolygon( mapped, merged ).getSource( 0 ).vertexCount == 0 );
+		delete mapped;
+	}
+
+	// Objects hierarchies which are not forests. The first building has its 3 surfaces as children.
+	uint32_t building = getBlock< uint32_t >( copy, binary::BT_Roots )[0];
+	const binary::ObjectRecord& record = getBlock< binary::ObjectRecord >( copy, binary::BT_Objects )[ building ];
+	CHECK( record.childrenCount == 3 );
+	if ( record.childrenCount != 3 ) return;
+	{
+		// Object listed twice as a child
+		std::string data = original;
+		uint32_t* children = getBlock< uint32_t >( data, binary::BT_Children );
+		children[ record.childrenFirst + 1 ] = children[ record.childrenFirst ];
+		CHECK( isHierarchyRejected( data ) );
+
+		// Object both root & child
+		data = original;
+		getBlock< uint32_t >( data, binary::BT_Roots )[1] = getBlock< uint32_t >( data, binary::BT_Children )[ record.childrenFirst ];
+		CHECK( isHierarchyRejected( data ) );
+
+		// Object which is its own parent, out of the reach of the roots, that the mapped model must not walk into
+		data = original;
+		binary::ObjectRecord* records = getBlock< binary::ObjectRecord >( data, binary::BT_Objects );
+		uint32_t first = records[ building ].childrenFirst;
+		uint32_t child = getBlock< uint32_t >( data, binary::BT_Children )[ first ];
+		records[ building ].childrenFirst = first + 1;
+		records[ building ].childrenCount = 2;
+		records[ child ].childrenFirst = first;
+		records[ child ].childrenCount = 1;
+		records[ child ].parent = child;
+		CHECK( isHierarchyRejected( data ) );
+		writeFile( FILENAME, data );
+		MappedCityModel* mapped = map_binary( FILENAME );
+		CHECK( mapped && mapped->getCityObject( child ).getChildCount() == 1 && !mapped->getCityObject( child ).getChild( 0 ).isValid() );
+		delete mapped;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main( void )
+{
+	if ( !binary::isLittleEndianHost() ) { std::cout << "Binary models are not supported on this host, skipped" << std::endl; return EXIT_SUCCESS; }
+
+	// The polygons data packed in the model arena, then in the shared buffers with the polygons of B1 without appearance merged
+	for ( unsigned int shared = 0; shared < 2; shared++ )
+	{
+		ParserParams params;
+		params.sharedBuffers = shared != 0;
+		params.optimize = shared != 0;
+		std::istringstream stream( SAMPLE );
+		CityModel* city = load( stream, params );
+		CHECK( city != 0 );
+		if ( !city ) return EXIT_FAILURE;
+		CHECK( city->getCityObjectsRoots().size() == 2 );
+		unsigned int textured = 0, materials = 0;
+		for ( unsigned int i = 0; i < city->getCityObjectsRoots().size(); i++ ) countAppearances( city->getCityObjectsRoots()[i], textured, materials );
+		CHECK( textured == 1 && materials == 2 );
+
+		CHECK( save_binary( *city, FILENAME ) );
+
+		CityModel* loaded = load_binary( FILENAME );
+		CHECK( loaded != 0 );
+		if ( loaded )
+		{
+			CHECK( loaded->getSRSName() == city->getSRSName() && loaded->getCityObjectsRoots().size() == city->getCityObjectsRoots().size() );
+			for ( unsigned int i = 0; i < std::min( loaded->getCityObjectsRoots().size(), city->getCityObjectsRoots().size() ); i++ )
+				compareObject( city->getCityObjectsRoots()[i], loaded->getCityObjectsRoots()[i] );
+			CHECK( loaded->getGeometryBuffers().getTexCoords().size() == 4 );
+			delete loaded;
+		}
+
+		MappedCityModel* mapped = map_binary( FILENAME );
+		CHECK( mapped != 0 );
+		if ( mapped )
+		{
+			CHECK( city->getSRSName() == mapped->getSRSName() && mapped->getRootsCount() == city->getCityObjectsRoots().size() );
+			for ( unsigned int i = 0; i < std::min( (size_t)mapped->getRootsCount(), city->getCityObjectsRoots().size() ); i++ )
+				compareObject( city->getCityObjectsRoots()[i], mapped->getRoot( i ) );
+			delete mapped;
+		}
+
+		if ( shared )
+		{
+			std::cerr << "The damaged files errors are expected:" << std::endl;
+			checkDamagedFiles( readFile( FILENAME ) );
+		}
+
+		delete city;
+		remove( FILENAME );
+	}
+
+	if ( failures ) std::cout << failures << " checks failed" << std::endl;
+	else std::cout << "All checks passed" << std::endl;
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+// Sidecar cache of the parsed files (see ParserParams::cacheDir): a second load comes from the sidecar,
+// a touched or edited file or other parameters are parsed again, and a damaged sidecar is quietly replaced
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#include "citygml.h"
+#include "binaryformat.h"
+
+using namespace citygml;
+
+static const char* FILENAME = "cachetest.gml";
+static const char* CACHEDIR = "cachetest_cache";
+
+static int failures = 0;
+
+#define CHECK( cond ) do { if ( !( cond ) ) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; failures++; } } while ( 0 )
+
+// A building with a wall surface, the owner attribute telling the file versions apart
+static std::string makeSample( const std::string& owner )
+{
+	std::ostringstream os;
+	os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<CityModel xmlns=\"http://www.opengis.net/citygml/1.0\" xmlns:gml=\"http://www.opengis.net/gml\" xmlns:bldg=\"http://www.opengis.net/citygml/building/1.0\""
+		<< " xmlns:gen=\"http://www.opengis.net/citygml/generics/1.0\">\n"
+		<< "<gml:boundedBy><gml:Envelope srsName=\"EPSG:25832\"><gml:lowerCorner>0 0 0</gml:lowerCorner><gml:upperCorner>10 10 10</gml:upperCorner></gml:Envelope></gml:boundedBy>\n"
+		<< "<cityObjectMember><bldg:Building gml:id=\"B0\">\n"
+		<< "<gen:stringAttribute name=\"owner\"><gen:value>" << owner << "</gen:value></gen:stringAttribute>\n"
+		<< "<bldg:boundedBy><bldg:WallSurface gml:id=\"B0_W0\"><bldg:lod2MultiSurface><gml:MultiSurface><gml:surfaceMember>"
+		<< "<gml:Polygon gml:id=\"B0_W0_P\"><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">0 0 0 10 0 0 10 0 10 0 0 10 0 0 0</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon>"
+		<< "</gml:surfaceMember></gml:MultiSurface></bldg:lod2MultiSurface></bldg:WallSurface></bldg:boundedBy>\n"
+		<< "</bldg:Building></cityObjectMember>\n"
+		<< "</CityModel>\n";
+	return os.str();
+}
+
+static std::string readFile( const std::string& fileName )
+{
+	std::ifstream in( fileName.c_str(), std::ios::binary );
+	std::ostringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static void writeFile( const std::string& fileName, const std::string& data )
+{
+	std::ofstream out( fileName.c_str(), std::ios::binary | std::ios::trunc );
+	out.write( data.data(), data.size() );
+}
+
+static void setModificationTime( const std::string& fileName, time_t time )
+{
+	struct utimbuf times;
+	times.actime = times.modtime = time;
+	utime( fileName.c_str(), &times );
+}
+
+// Load the sample, check its content and tell whether it came from the sidecar: a model loaded from a binary file
+// has its polygons in the shared buffers (see save_binary), unlike the parsed ones. The cache misses must be quiet.
+static bool isLoadedFromCache( const ParserParams& params, const std::string& owner )
+{
+	std::ostringstream errors;
+	std::streambuf* previous = std::cerr.rdbuf( errors.rdbuf() );
+	CityModel* city = load( FILENAME, params );
+	std::cerr.rdbuf( previous );
+	CHECK( errors.str().empty() );
+
+	CHECK( city && city->getCityObjectsRoots().size() == 1 );
+	if ( !city || city->getCityObjectsRoots().size() != 1 ) { delete city; return false; }
+	const CityObject* building = city->getCityObjectsRoots()[0];
+	CHECK( building->getId() == "B0" && building->getAttribute( "owner" ) == owner && building->getChildCount() == 1 );
+
+	bool cached = !city->getGeometryBuffers().getVertices().empty();
+	delete city;
+	return cached;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main( void )
+{
+	if ( !binary::isLittleEndianHost() ) { std::cout << "Binary models are not supported on this host, skipped" << std::endl; return EXIT_SUCCESS; }
+
+	const time_t time = 1000000000;
+	writeFile( FILENAME, makeSample( "Owner A" ) );
+	setModificationTime( FILENAME, time );
+
+	ParserParams params;
+	params.cacheDir = CACHEDIR;
+	ParserParams other = params;
+	other.maxLOD = 3;
+	ParserParams unkeyed = params;
+	unkeyed.threads = 2;
+
+	// The sidecars left by a previous run
+	const std::string path = ModelCache( FILENAME, params ).getPath(), otherPath = ModelCache( FILENAME, other ).getPath();
+	CHECK( !path.empty() && !otherPath.empty() && path != otherPath && ModelCache( FILENAME, unkeyed ).getPath() == path );
+	remove( path.c_str() );
+	remove( otherPath.c_str() );
+
+	// Parsed & saved, then loaded from the sidecar, also with parameters which do not change the model
+	CHECK( !isLoadedFromCache( params, "Owner A" ) );
+	CHECK( !readFile( path ).empty() );
+	CHECK( isLoadedFromCache( params, "Owner A" ) );
+	CHECK( isLoadedFromCache( unkeyed, "Owner A" ) );
+
+	// Touched file
+	setModificationTime( FILENAME, time + 10 );
+	CHECK( !isLoadedFromCache( params, "Owner A" ) );
+	CHECK( isLoadedFromCache( params, "Owner A" ) );
+
+	// Edited file of the same size & modification time
+	writeFile( FILENAME, makeSample( "Owner B" ) );
+	setModificationTime( FILENAME, time + 10 );
+	CHECK( !isLoadedFromCache( params, "Owner B" ) );
+	CHECK( isLoadedFromCache( params, "Owner B" ) );
+
+	// Other parameters, with their own sidecar
+	CHECK( !isLoadedFromCache( other, "Owner B" ) );
+	CHECK( isLoadedFromCache( other, "Owner B" ) );
+	CHECK( isLoadedFromCache( params, "Owner B" ) );
+
+	// Damaged sidecar with a valid key: parsed again, then replaced
+	std::string data = readFile( path );
+	CHECK( data.size() > sizeof( binary::FileHeader ) );
+	if ( data.size() > sizeof( binary::FileHeader ) )
+	{
+		const binary::FileHeader* header = (const binary::FileHeader*)&data[0];
+		binary::BlockEntry* entries = (binary::BlockEntry*)&data[ sizeof( binary::FileHeader ) ];
+		for ( uint32_t i = 0; i < header->blocksCount; i++ ) if ( entries[i].type == binary::BT_Objects ) entries[i].count++;
+		writeFile( path, data );
+		CHECK( !isLoadedFromCache( params, "Owner B" ) );
+		CHECK( isLoadedFromCache( params, "Owner B" ) );
+	}
+
+	remove( path.c_str() );
+	remove( otherPath.c_str() );
+	remove( CACHEDIR );
+	remove( FILENAME );
+
+	if ( failures ) std::cout << failures << " checks failed" << std::endl;
+	else std::cout << "All checks passed" << std::endl;
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+// Comparison of the spatial index queries with a linear scan of the objects, on a generated model
+// whose lazy tesselation must be left pending by the index construction
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdlib>
+#include "citygml.h"
+
+using namespace citygml;
+
+static int failures = 0;
+
+#define CHECK( cond ) do { if ( !( cond ) ) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; failures++; } } while ( 0 )
+
+// Deterministic pseudo random numbers in [0, 1), unlike rand() the same on every platform
+static double random01( void )
+{
+	static unsigned long long state = 12345;
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return ( state >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+static void writePolygon( std::ostream& os, double x0, double y0, double z0, double x1, double y1, double z1 )
+{
+	// Vertical quad when z0 != z1, else horizontal
+	os << "<gml:surfaceMember><gml:Polygon><gml:exterior><gml:LinearRing><gml:posList srsDimension=\"3\">";
+	if ( z0 != z1 ) os << x0 << " " << y0 << " " << z0 << " " << x1 << " " << y1 << " " << z0 << " " << x1 << " " << y1 << " " << z1 << " " << x0 << " " << y0 << " " << z1 << " " << x0 << " " << y0 << " " << z0;
+	else os << x0 << " " << y0 << " " << z0 << " " << x1 << " " << y0 << " " << z0 << " " << x1 << " " << y1 << " " << z0 << " " << x0 << " " << y1 << " " << z0 << " " << x0 << " " << y0 << " " << z0;
+	os << "</gml:posList></gml:LinearRing></gml:exterior></gml:Polygon></gml:surfaceMember>";
+}
+
+// Buildings with a wall & a roof surface, a third of them with an envelope, the others bounded by their polygons
+static std::string makeSample( unsigned int count )
+{
+	std::ostringstream os;
+	os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<CityModel xmlns=\"http://www.opengis.net/citygml/1.0\" xmlns:gml=\"http://www.opengis.net/gml\" xmlns:bldg=\"http://www.opengis.net/citygml/building/1.0\">\n";
+	for ( unsigned int i = 0; i < count; i++ )
+	{
+		double x = 1000. * random01(), y = 1000. * random01(), w = 5. + 20. * random01(), h = 3. + 30. * random01();
+		os << "<cityObjectMember><bldg:Building gml:id=\"B" << i << "\">";
+		if ( i % 3 == 0 ) os << "<gml:boundedBy><gml:Envelope><gml:lowerCorner>" << x << " " << y << " 0</gml:lowerCorner><gml:upperCorner>" << x + w << " " << y + w << " " << h << "</gml:upperCorner></gml:Envelope></gml:boundedBy>";
+		if ( i % 5 == 0 ) { os << "<bldg:lod1MultiSurface><gml:MultiSurface>"; writePolygon( os, x, y + w, 0., x, y, h ); os << "</gml:MultiSurface></bldg:lod1MultiSurface>"; }
+		os << "<bldg:boundedBy><bldg:WallSurface gml:id=\"B" << i << "_W\"><bldg:lod2MultiSurface><gml:MultiSurface>";
+		writePolygon( os, x, y, 0., x + w, y, h );
+		os << "</gml:MultiSurface></bldg:lod2MultiSurface></bldg:WallSurface></bldg:boundedBy>";
+		os << "<bldg:boundedBy><bldg:RoofSurface gml:id=\"B" << i << "_R\"><bldg:lod2MultiSurface><gml:MultiSurface>";
+		writePolygon( os, x, y, h, x + w, y + w, h );
+		os << "</gml:MultiSurface></bldg:lod2MultiSurface></bldg:RoofSurface></bldg:boundedBy>";
+		os << "</bldg:Building></cityObjectMember>\n";
+	}
+	os << "</CityModel>\n";
+	return os.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool isPending( const CityObject* obj )
+{
+	for ( unsigned int i = 0; i < obj->size(); i++ )
+		for ( unsigned int j = 0; j < obj->getGeometry( i )->size(); j++ )
+			if ( !(*obj->getGeometry( i ))[j]->isTesselationPending() ) return false;
+	for ( unsigned int i = 0; i < obj->getChildCount(); i++ ) if ( !isPending( obj->getChild( i ) ) ) return false;
+	return true;
+}
+
+static void extend( TVec3d& lower, TVec3d& upper, const TVec3d& p )
+{
+	for ( unsigned int i = 0; i < 3; i++ ) { lower[i] = std::min( lower[i], p[i] ); upper[i] = std::max( upper[i], p[i] ); }
+}
+
+// The bounds the index is expected to use: the envelope, or else the bounding box of the polygons & children
+static bool getBounds( const CityObject* obj, TVec3d& lower, TVec3d& upper )
+{
+	const Envelope& e = obj->getEnvelope();
+	if ( e.getLowerBound() != TVec3d( 0., 0., 0. ) || e.getUpperBound() != TVec3d( 0., 0., 0. ) ) { lower = e.getLowerBound(); upper = e.getUpperBound(); return true; }
+
+	lower = TVec3d( 1e300, 1e300, 1e300 );
+	upper = TVec3d( -1e300, -1e300, -1e300 );
+	bool found = false;
+	for ( unsigned int i = 0; i < obj->size(); i++ )
+		for ( unsigned int j = 0; j < obj->getGeometry( i )->size(); j++ )
+		{
+			ArrayView<TVec3d> vertices = (*obj->getGeometry( i ))[j]->getVertices();
+			for ( unsigned int k = 0; k < vertices.size(); k++ ) { extend( lower, upper, vertices[k] ); found = true; }
+		}
+	for ( unsigned int i = 0; i < obj->getChildCount(); i++ )
+	{
+		TVec3d l, u;
+		if ( getBounds( obj->getChild( i ), l, u ) ) { extend( lower, upper, l ); extend( lower, upper, u ); found = true; }
+	}
+	return found;
+}
+
+static double distance2( const TVec3d& lower, const TVec3d& upper, const TVec3d& p )
+{
+	double d = 0.;
+	for ( unsigned int i = 0; i < 3; i++ )
+	{
+		double delta = std::max( std::max( lower[i] - p[i], p[i] - upper[i] ), 0. );
+		d += delta * delta;
+	}
+	return d;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main( void )
+{
+	ParserParams params;
+	params.lazyTesselation = true;
+	params.spatialIndex = true;
+	std::istringstream stream( makeSample( 600 ) );
+	CityModel* city = load( stream, params );
+	CHECK( city != 0 );
+	if ( !city ) return EXIT_FAILURE;
+
+	const SpatialIndex* index = city->getSpatialIndex();
+	CHECK( index != 0 );
+	if ( !index ) return EXIT_FAILURE;
+
+	// Building the index must not have tesselated the polygons
+	for ( unsigned int i = 0; i < city->getCityObjectsRoots().size(); i++ ) CHECK( isPending( city->getCityObjectsRoots()[i] ) );
+
+	// All the objects of the linear scan, with their bounds
+	std::vector< const CityObject* > objects;
+	std::vector< TVec3d > lowers, uppers;
+	for ( CityObjectsMap::const_iterator it = city->getCityObjectsMap().begin(); it != city->getCityObjectsMap().end(); ++it )
+		for ( unsigned int i = 0; i < it->second.size(); i++ )
+		{
+			TVec3d l, u;
+			if ( !getBounds( it->second[i], l, u ) ) continue;
+			objects.push_back( it->second[i] );
+			lowers.push_back( l );
+			uppers.push_back( u );
+		}
+	CHECK( index->size() == objects.size() && objects.size() == 600 * 3 );
+
+	// Mixed box, point & nearest queries, with various types filters
+	const CityObjectsTypeMask masks[] = { COT_All, COT_Building, COT_WallSurface | COT_RoofSurface, COT_RoofSurface };
+	unsigned int hits = 0;
+	for ( unsigned int q = 0; q < 2000; q++ )
+	{
+		CityObjectsTypeMask mask = masks[ q % 4 ];
+		TVec3d lower( 1100. * random01() - 50., 1100. * random01() - 50., 40. * random01() - 5. );
+		TVec3d upper = lower;
+		if ( q % 3 == 0 ) upper = lower + TVec3d( 60. * random01(), 60. * random01(), 10. * random01() );
+
+		if ( q % 3 != 2 )
+		{
+			std::vector< const CityObject* > result;
+			if ( q % 3 == 0 ) index->intersect( Envelope( lower, upper ), result, mask );
+			else index->contain( lower, result, mask );
+
+			std::set< const CityObject* > expected;
+			for ( unsigned int i = 0; i < objects.size(); i++ )
+				if ( ( objects[i]->getType() & mask ) && lowers[i].x <= upper.x && lower.x <= uppers[i].x && lowers[i].y <= upper.y && lower.y <= uppers[i].y && lowers[i].z <= upper.z && lower.z <= uppers[i].z )
+					expected.insert( objects[i] );
+
+			CHECK( result.size() == expected.size() && std::set< const CityObject* >( result.begin(), result.end() ) == expected );
+			hits += result.size();
+		}
+		else
+		{
+			unsigned int k = 1 + q % 10;
+			std::vector< const CityObject* > result;
+			index->nearest( lower, k, result, mask );
+
+			// The distances must be the k smallest ones, in order; the objects at the same distance may come in any order
+			std::vector< double > distances;
+			for ( unsigned int i = 0; i < objects.size(); i++ ) if ( objects[i]->getType() & mask ) distances.push_back( distance2( lowers[i], uppers[i], lower ) );
+			std::sort( distances.begin(), distances.end() );
+
+			CHECK( result.size() == std::min( (size_t)k, distances.size() ) );
+			for ( unsigned int i = 0; i < result.size() && i < distances.size(); i++ )
+			{
+				unsigned int j = std::find( objects.begin(), objects.end(), result[i] ) - objects.begin();
+				CHECK( j < objects.size() && ( result[i]->getType() & mask ) && distance2( lowers[j], uppers[j], lower ) == distances[i] );
+			}
+		}
+	}
+	CHECK( hits > 100 );
+
+	delete city;
+
+	if ( failures ) std::cout << failures << " checks failed" << std::endl;
+	else std::cout << "All checks passed" << std::endl;
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+/* -*-c++-*- libcitygml - Copyright (c) 2010 Joachim Pouderoux, BRGM
+*
+* This file is part of libcitygml library
+* http://code.google.com/p/libcitygml
+*
+* libcitygml is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 2.1 of the License, or
+* (at your option) any later version.
+*
+* libcitygml is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*/
+
+// Tesselation of convex, concave, holed & degenerated polygons: the triangles must cover the polygon area,
+// keep its orientation, and the texture coordinates must stay attached to their vertices
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include "citygml.h"
+
+using namespace citygml;
+
+static int failures = 0;
+
+#define CHECK( cond ) do { if ( !( cond ) ) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; failures++; } } while ( 0 )
+
+typedef std::vector< std::pair< double, double > > Ring2d;
+
+// Test polygon, given by its rings in its plane: either horizontal (z = 5) or vertical (y = 5, the second coordinate being z)
+struct TestPolygon
+{
+	std::string id;
+	bool vertical;
+	Ring2d exterior;
+	std::vector< Ring2d > interiors;
+};
+
+static TVec3d toPoint( const TestPolygon& p, double a, double b )
+{
+	return p.vertical ? TVec3d( a, 5., b ) : TVec3d( a, b, 5. );
+}
+
+// The texture coordinates are a linear function of the position, so that they can be checked on the output vertices
+static TVec2f toTexCoord( double a, double b )
+{
+	return TVec2f( (float)( a / 40. ), (float)( b / 40. ) );
+}
+
+static double getArea( const Ring2d& ring )
+{
+	double area = 0.;
+	for ( unsigned int i = 0, j = ring.size() - 1; i < ring.size(); j = i++ ) area += ring[j].first * ring[i].second - ring[i].first * ring[j].second;
+	return fabs( area ) / 2.;
+}
+
+static Ring2d makeRing( const double* coords, unsigned int count )
+{
+	Ring2d ring;
+	for ( unsigned int i = 0; i < count; i++ ) ring.push_back( std::make_pair( coords[ 2 * i ], coords[ 2 * i + 1 ] ) );
+	return ring;
+}
+
+static std::vector< TestPolygon > makePolygons( void )
+{
+	std::vector< TestPolygon > polygons;
+	TestPolygon p;
+
+	// Convex, counter-clockwise then clockwise (ie. facing down)
+	const double square[] = { 0, 0, 10, 0, 10, 10, 0, 10 };
+	p.id = "CONVEX"; p.vertical = false; p.exterior = makeRing( square, 4 );
+	polygons.push_back( p );
+
+	const double pentagon[] = { 0, 0, 3, 8, 10, 10, 12, 4, 8, -2 };
+	p.id = "CONVEX_CW"; p.exterior = makeRing( pentagon, 5 );
+	polygons.push_back( p );
+
+	// Concave: a U, and a comb with reflex vertices on a vertical wall
+	const double u[] = { 0, 0, 30, 0, 30, 20, 20, 20, 20, 10, 10, 10, 10, 20, 0, 20 };
+	p.id = "CONCAVE"; p.exterior = makeRing( u, 8 );
+	polygons.push_back( p );
+
+	const double comb[] = { 0, 0, 25, 0, 25, 15, 20, 15, 20, 5, 15, 5, 15, 15, 10, 15, 10, 5, 5, 5, 5, 15, 0, 15 };
+	p.id = "CONCAVE_WALL"; p.vertical = true; p.exterior = makeRing( comb, 12 );
+	polygons.push_back( p );
+
+	// Holes, one of them with the same orientation as the exterior ring
+	const double outer[] = { 0, 0, 20, 0, 20, 20, 0, 20 };
+	const double hole1[] = { 2, 2, 2, 6, 6, 6, 6, 2 };
+	const double hole2[] = { 10, 10, 16, 10, 16, 14, 10, 14 };
+	p.id = "HOLED"; p.vertical = false; p.exterior = makeRing( outer, 4 );
+	p.interiors.push_back( makeRing( hole1, 4 ) );
+	p.interiors.push_back( makeRing( hole2, 4 ) );
+	polygons.push_back( p );
+
+	p.id = "HOLED_WALL"; p.vertical = true;
+	polygons.push_back( p );
+	p.interiors.clear();
+
+	// Collinear vertices along the edges, and a concave ring starting on a collinear vertex
+	const double midpoints[] = { 0, 0, 5, 0, 10, 0, 10, 5, 10, 10, 5, 10, 0, 10, 0, 5 };
+	p.id = "COLLINEAR"; p.vertical = false; p.exterior = makeRing( midpoints, 8 );
+	polygons.push_back( p );
+
+	const double notch[] = { 5, 0, 10, 0, 10, 10, 5, 5, 0, 10, 0, 0 };
+	p.id = "COLLINEAR_CONCAVE"; p.exterior = makeRing( notch, 6 );
+	polygons.push_back( p );
+
+	// Degenerated: all the vertices on a line, and a repeated vertex
+	const double line[] = { 0, 0, 5, 0, 10, 0, 20, 0 };
+	p.id = "FLAT"; p.exterior = makeRing( line, 4 );
+	polygons.push_back( p );
+
+	const double repeated[] = { 0, 0, 10, 0, 10, 0, 10, 10, 0, 10 };
+	p.id = "REPEATED"; p.exterior = makeRing( repeated, 5 );
+	polygons.push_back( p );
+
+	return polygons;
+}
+
+static void writeRing( std::ostream& os, const TestPolygon& p, const Ring2d& ring, const std::string& id, bool exterior )
+{
+	os << ( exterior ? "<gml:exterior>" : "<gml:interior>" ) << "<gml:LinearRing gml:id=\"" << id << "\"><gml:posList srsDimension=\"3\">";
+	for ( unsigned int i = 0; i <= ring.size(); i++ )
+	{
+		TVec3d v = toPoint( p, ring[ i % ring.size() ].first, ring[ i % ring.size() ].second );
+		os << v.x << " " << v.y << " " << v.z << " ";
+	}
+	os << "</gml:posList></gml:LinearRing>" << ( exterior ? "</gml:exterior>" : "</gml:interior>" );
+}
+
+static void writeTexCoords( std::ostream& os, const Ring2d& ring, const std::string& id )
+{
+	os << "<app:textureCoordinates ring=\"#" << id << "\">";
+	for ( unsigned int i = 0; i <= ring.size(); i++ )
+	{
+		TVec2f t = toTexCoord( ring[ i % ring.size() ].first, ring[ i % ring.size() ].second );
+		os << t.x << " " << t.y << " ";
+	}
+	os << "</app:textureCoordinates>";
+}
+
+static std::string makeSample( const std::vector< TestPolygon >& polygons )
+{
+	std::ostringstream os;
+	os.precision( 10 );
+	os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<CityModel xmlns=\"http://www.opengis.net/citygml/1.0\" xmlns:gml=\"http://www.opengis.net/gml\" xmlns:bldg=\"http://www.opengis.net/citygml/building/1.0\""
+		<< " xmlns:app=\"http://www.opengis.net/citygml/appearance/1.0\">\n"
+		<< "<cityObjectMember><bldg:Building gml:id=\"B\"><bldg:lod2MultiSurface><gml:MultiSurface>\n";
+	for ( unsigned int i = 0; i < polygons.size(); i++ )
+	{
+		const TestPolygon& p = polygons[i];
+		os << "<gml:surfaceMember><gml:Polygon gml:id=\"" << p.id << "\">";
+		writeRing( os, p, p.exterior, p.id + "_0", true );
+		for ( unsigned int j = 0; j < p.interiors.size(); j++ )
+		{
+			std::ostringstream id;
+			id << p.id << "_" << j + 1;
+			writeRing( os, p, p.interiors[j], id.str(), false );
+		}
+		os << "</gml:Polygon></gml:surfaceMember>\n";
+	}
+	os << "</gml:MultiSurface></bldg:lod2MultiSurface></bldg:Building></cityObjectMember>\n";
+
+	os << "<app:appearanceMember><app:Appearance><app:surfaceDataMember><app:ParameterizedTexture gml:id=\"TEX\"><app:imageURI>tex.jpg</app:imageURI>\n";
+	for ( unsigned int i = 0; i < polygons.size(); i++ )
+	{
+		const TestPolygon& p = polygons[i];
+		os << "<app:target uri=\"#" << p.id << "\"><app:TexCoordList>";
+		writeTexCoords( os, p.exterior, p.id + "_0" );
+		for ( unsigned int j = 0; j < p.interiors.size(); j++ )
+		{
+			std::ostringstream id;
+			id << p.id << "_" << j + 1;
+			writeTexCoords( os, p.interiors[j], id.str() );
+		}
+		os << "</app:TexCoordList></app:target>\n";
+	}
+	os << "</app:ParameterizedTexture></app:surfaceDataMember></app:Appearance></app:appearanceMember>\n";
+	os << "</CityModel>\n";
+	return os.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void checkPolygon( const TestPolygon& test, const Polygon* p )
+{
+	ArrayView<TVec3d> vertices = p->getVertices();
+	ArrayView<unsigned int> indices = p->getIndices();
+	ArrayView<TVec2f> texCoords = p->getTexCoords();
+	TVec3d normal( p->getNormal().x, p->getNormal().y, p->getNormal().z );
+
+	CHECK( indices.size() % 3 == 0 );
+	CHECK( texCoords.size() == vertices.size() );
+
+	double expected = getArea( test.exterior );
+	for ( unsigned int i = 0; i < test.interiors.size(); i++ ) expected -= getArea( test.interiors[i] );
+
+	// The triangles must not overlap, nor be flipped, so their areas sum up to the polygon one
+	double area = 0.;
+	bool valid = true, oriented = true;
+	for ( unsigned int i = 0; i + 2 < indices.size(); i += 3 )
+	{
+		if ( indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() || indices[i + 2] >= vertices.size() ) { valid = false; continue; }
+		TVec3d cross = ( vertices[ indices[i + 1] ] - vertices[ indices[i] ] ).cross( vertices[ indices[i + 2] ] - vertices[ indices[i] ] );
+		area += cross.length() / 2.;
+		if ( cross.dot( normal ) < -1e-9 ) oriented = false;
+	}
+	CHECK( valid );
+	CHECK( oriented );
+	CHECK( fabs( area - expected ) <= 1e-6 * ( 1. + expected ) );
+	if ( !valid || !oriented || fabs( area - expected ) > 1e-6 * ( 1. + expected ) ) std::cerr << "  in polygon " << test.id << ": area " << area << " instead of " << expected << std::endl;
+
+	// Each vertex keeps its texture coordinates
+	bool attached = texCoords.size() == vertices.size();
+	for ( unsigned int i = 0; attached && i < vertices.size(); i++ )
+	{
+		TVec2f t = test.vertical ? toTexCoord( vertices[i].x, vertices[i].z ) : toTexCoord( vertices[i].x, vertices[i].y );
+		attached = fabs( texCoords[i].x - t.x ) < 1e-5 && fabs( texCoords[i].y - t.y ) < 1e-5;
+	}
+	CHECK( attached );
+	if ( !attached ) std::cerr << "  in polygon " << test.id << ": texture coordinates detached from their vertices" << std::endl;
+}
+
+int main( void )
+{
+	std::vector< TestPolygon > polygons = makePolygons();
+	std::string sample = makeSample( polygons );
+
+	// Tesselated during the parse, then on demand
+	for ( unsigned int lazy = 0; lazy < 2; lazy++ )
+	{
+		ParserParams params;
+		params.lazyTesselation = lazy != 0;
+		std::istringstream stream( sample );
+		CityModel* city = load( stream, params );
+		CHECK( city != 0 );
+		if ( !city ) return EXIT_FAILURE;
+
+		std::map< std::string, const Polygon* > parsed;
+		const CityObjectsMap& objects = city->getCityObjectsMap();
+		for ( CityObjectsMap::const_iterator it = objects.begin(); it != objects.end(); ++it )
+			for ( unsigned int i = 0; i < it->second.size(); i++ )
+				for ( unsigned int j = 0; j < it->second[i]->size(); j++ )
+				{
+					const Geometry& geom = *it->second[i]->getGeometry( j );
+					for ( unsigned int k = 0; k < geom.size(); k++ ) parsed[ geom[k]->getId() ] = geom[k];
+				}
+
+		for ( unsigned int i = 0; i < polygons.size(); i++ )
+		{
+			std::map< std::string, const Polygon* >::const_iterator found = parsed.find( polygons[i].id );
+			CHECK( found != parsed.end() );
+			if ( found != parsed.end() ) checkPolygon( polygons[i], found->second );
+		}
+
+		delete city;
+	}
+
+	if ( failures ) std::cout << failures << " checks failed" << std::endl;
+	else std::cout << "All checks passed" << std::endl;
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}